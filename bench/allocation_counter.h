@@ -0,0 +1,55 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+
+#include <benchmark/benchmark.h>
+
+namespace nekit {
+namespace bench {
+
+// The number of calls to the global `operator new` so far.
+size_t AllocationCount();
+
+// Report the heap allocations made per iteration as the `allocs/op` counter.
+// Create it right before the benchmark loop, the allocations made by the
+// setup inside the loop are counted too.
+class AllocationCounter {
+ public:
+  explicit AllocationCounter(benchmark::State& state)
+      : state_{state}, start_{AllocationCount()} {}
+
+  ~AllocationCounter() {
+    state_.counters["allocs/op"] =
+        benchmark::Counter(static_cast<double>(AllocationCount() - start_),
+                           benchmark::Counter::kAvgIterations);
+  }
+
+ private:
+  benchmark::State& state_;
+  size_t start_;
+};
+
+}  // namespace bench
+}  // namespace nekit
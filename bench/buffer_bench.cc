@@ -0,0 +1,163 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstring>
+
+#include <benchmark/benchmark.h>
+
+#include "nekit/utils/buffer.h"
+#include "nekit/utils/buffer_pool.h"
+
+#include "allocation_counter.h"
+
+using namespace nekit;
+
+namespace {
+
+utils::Buffer ChunkedBuffer(size_t chunk_size, size_t chunk_count) {
+  utils::Buffer buffer;
+  for (size_t i = 0; i < chunk_count; i++) {
+    utils::Buffer chunk{chunk_size};
+    chunk.ForEachChunk([](void* data, size_t len) {
+      std::memset(data, 'a', len);
+      return true;
+    });
+    buffer.InsertBack(std::move(chunk));
+  }
+  return buffer;
+}
+
+void BM_BufferInsertBack(benchmark::State& state) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+  const size_t chunk_size = state.range(0);
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    utils::Buffer buffer;
+    for (size_t i = 0; i < 16; i++) {
+      buffer.InsertBack(utils::Buffer(chunk_size));
+    }
+    benchmark::DoNotOptimize(buffer.size());
+  }
+  state.SetItemsProcessed(state.iterations() * 16);
+}
+BENCHMARK(BM_BufferInsertBack)->Arg(64)->Arg(1500)->Arg(16384);
+
+// Prepend a protocol header to a read buffer, with and without the space
+// reserved in front of the data.
+void BM_BufferInsertFront(benchmark::State& state) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+  const size_t reserve_size = state.range(0);
+  utils::Buffer buffer{NEKIT_TCP_SOCKET_READ_SIZE,
+                       utils::BufferReserveSize{reserve_size, 0}};
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    buffer.InsertFront(32);
+    buffer.ShrinkFront(32);
+  }
+}
+BENCHMARK(BM_BufferInsertFront)->Arg(0)->Arg(32);
+
+void BM_BufferWalk(benchmark::State& state) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+  const utils::Buffer buffer = ChunkedBuffer(1024, state.range(0));
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    size_t sum = 0;
+    buffer.ForEachChunk([&sum](const void* data, size_t len) {
+      sum += static_cast<const uint8_t*>(data)[len - 1];
+      return true;
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BufferWalk)->Arg(4)->Arg(64)->Arg(1024);
+
+void BM_BufferRandomAccess(benchmark::State& state) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+  const size_t chunk_count = state.range(0);
+  const utils::Buffer buffer = ChunkedBuffer(64, chunk_count);
+  const size_t size = buffer.size();
+
+  bench::AllocationCounter counter{state};
+  size_t pos = 0;
+  for (auto _ : state) {
+    pos = (pos + 4099) % size;
+    benchmark::DoNotOptimize(buffer[pos]);
+  }
+}
+BENCHMARK(BM_BufferRandomAccess)->Arg(16)->Arg(1024);
+
+void BM_BufferBreak(benchmark::State& state) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+  utils::Buffer buffer = ChunkedBuffer(1024, state.range(0));
+  const size_t middle = buffer.size() / 2 + 1;
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    utils::Buffer tail = buffer.Break(middle);
+    buffer.InsertBack(std::move(tail));
+  }
+}
+BENCHMARK(BM_BufferBreak)->Arg(4)->Arg(64);
+
+void BM_BufferShrink(benchmark::State& state) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+  const size_t chunk_count = state.range(0);
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    state.PauseTiming();
+    utils::Buffer buffer = ChunkedBuffer(1024, chunk_count);
+    state.ResumeTiming();
+
+    buffer.Shrink(100, buffer.size() - 200);
+    benchmark::DoNotOptimize(buffer.size());
+  }
+}
+BENCHMARK(BM_BufferShrink)->Arg(4)->Arg(64);
+
+void BM_BufferFind(benchmark::State& state) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+  const size_t chunk_size = state.range(0);
+  utils::Buffer buffer = ChunkedBuffer(chunk_size, 65536 / chunk_size);
+  buffer.SetData(buffer.size() - 4, 4, "\r\n\r\n");
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(buffer.Find("\r\n\r\n", 4));
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_BufferFind)->Arg(64)->Arg(1500)->Arg(65536);
+
+}  // namespace
@@ -0,0 +1,157 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <boost/asio.hpp>
+
+#include "nekit/data_flow/http_server_data_flow.h"
+#include "nekit/rule/all_rule.h"
+#include "nekit/rule/rule_manager.h"
+#include "nekit/transport/tcp_listener.h"
+#include "nekit/transport/tcp_socket.h"
+#include "nekit/transport/tunnel.h"
+#include "nekit/utils/buffer_pool.h"
+#include "nekit/utils/runloop.h"
+
+#include "allocation_counter.h"
+
+using namespace nekit;
+using boost::asio::ip::tcp;
+
+namespace {
+
+// client -> HTTP proxy => tunnel -> server, all over loopback. Each iteration
+// opens a tunnel and closes it right after it is established.
+class ConnectionFixture {
+ public:
+  ConnectionFixture()
+      : listener_{&runloop_,
+                  [](std::unique_ptr<data_flow::LocalDataFlowInterface>&&
+                         data_flow) {
+                    auto session = data_flow->Session();
+                    return std::make_unique<data_flow::HttpServerDataFlow>(
+                        std::move(data_flow), session);
+                  }},
+        rule_manager_{&runloop_},
+        acceptor_{*runloop_.BoostIoContext(),
+                  {boost::asio::ip::address_v4::loopback(), 0}} {
+    rule_manager_.AppendRule(std::make_shared<rule::AllRule>(
+        [](std::shared_ptr<utils::Session> session) {
+          return std::make_unique<transport::TcpSocket>(session);
+        }));
+
+    listener_.SetBacklog(1024);
+    listener_.Bind("127.0.0.1", 0);
+    listener_.Accept(
+        [this](utils::Result<
+                   std::unique_ptr<data_flow::LocalDataFlowInterface>>&&
+                   data_flow) {
+          if (data_flow) {
+            tunnel_manager_.Build(*std::move(data_flow), &rule_manager_).Open();
+          }
+        });
+
+    request_ = "CONNECT 127.0.0.1:" +
+               std::to_string(acceptor_.local_endpoint().port()) +
+               " HTTP/1.1\r\n\r\n";
+    Accept();
+  }
+
+  void Connect() {
+    tcp::socket client{*runloop_.BoostIoContext()};
+    client.connect(listener_.local_endpoint());
+    boost::asio::write(client, boost::asio::buffer(request_));
+
+    bool connected = false;
+    boost::asio::streambuf response;
+    boost::asio::async_read_until(
+        client, response, "\r\n\r\n",
+        [&connected](const boost::system::error_code&, size_t) {
+          connected = true;
+        });
+    RunUntil([&connected]() { return connected; });
+
+    client.close();
+    RunUntil([this]() { return !tunnel_manager_.tunnel_count(); });
+  }
+
+  utils::Runloop* runloop() { return &runloop_; }
+
+ private:
+  void RunUntil(std::function<bool()> done) {
+    // The context is stopped whenever it runs out of work.
+    runloop_.BoostIoContext()->restart();
+    while (!done()) {
+      runloop_.BoostIoContext()->run_one();
+    }
+  }
+
+  // The server closes the connection once the tunnel closes its side.
+  void Accept() {
+    auto server = std::make_shared<tcp::socket>(*runloop_.BoostIoContext());
+    acceptor_.async_accept(
+        *server, [this, server](const boost::system::error_code& ec) {
+          if (ec) {
+            return;
+          }
+          Drain(server);
+          Accept();
+        });
+  }
+
+  void Drain(std::shared_ptr<tcp::socket> server) {
+    server->async_read_some(
+        boost::asio::buffer(buffer_),
+        [this, server](const boost::system::error_code& ec, size_t) {
+          if (!ec) {
+            Drain(server);
+          }
+        });
+  }
+
+  utils::Runloop runloop_;
+  transport::TcpListener listener_;
+  rule::RuleManager rule_manager_;
+  transport::TunnelManager tunnel_manager_;
+  tcp::acceptor acceptor_;
+  std::string request_;
+  char buffer_[4096];
+};
+
+void BM_TunnelSetup(benchmark::State& state) {
+  ConnectionFixture fixture;
+  utils::BufferPool::Scope scope{fixture.runloop()->GetBufferPool()};
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    fixture.Connect();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TunnelSetup)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+}  // namespace
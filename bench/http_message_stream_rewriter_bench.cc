@@ -0,0 +1,101 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "nekit/utils/buffer.h"
+#include "nekit/utils/buffer_pool.h"
+#include "nekit/utils/http_message_stream_rewriter.h"
+
+#include "allocation_counter.h"
+
+using namespace nekit;
+
+namespace {
+
+const std::string kRequest =
+    "GET http://www.example.com/index.html?query=1 HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_13_6) "
+    "AppleWebKit/537.36 (KHTML, like Gecko) Chrome/69.0.3497.100 "
+    "Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;"
+    "q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "Proxy-Connection: keep-alive\r\n"
+    "Cookie: session=0123456789abcdef0123456789abcdef\r\n"
+    "\r\n";
+
+// Rewrite the request the way a forward proxy does, strip the scheme and host
+// from the URL and remove the proxy headers.
+class ProxyRequestRewriterDelegate
+    : public utils::HttpMessageStreamRewriterDelegateInterface {
+ public:
+  bool OnUrl(utils::HttpMessageStreamRewriter* rewriter) override {
+    rewriter->RewriteCurrentToken("/index.html?query=1");
+    return true;
+  }
+
+  bool OnHeaderPair(utils::HttpMessageStreamRewriter* rewriter) override {
+    if (rewriter->CurrentHeader().first == "Proxy-Connection") {
+      rewriter->DeleteCurrentHeader();
+    }
+    return true;
+  }
+};
+
+void BM_HttpMessageStreamRewriterRewriteBuffer(benchmark::State& state) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+
+  std::shared_ptr<utils::HttpMessageStreamRewriterDelegateInterface> delegate;
+  if (state.range(0)) {
+    delegate = std::make_shared<ProxyRequestRewriterDelegate>();
+  } else {
+    delegate =
+        std::make_shared<utils::HttpMessageStreamRewriterDelegateInterface>();
+  }
+  utils::HttpMessageStreamRewriter rewriter{
+      utils::HttpMessageStreamRewriter::Type::Request, delegate};
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    utils::Buffer buffer{kRequest.size()};
+    buffer.SetData(0, kRequest.size(), kRequest.data());
+    if (!rewriter.RewriteBuffer(&buffer)) {
+      state.SkipWithError("failed to parse the request");
+      return;
+    }
+    benchmark::DoNotOptimize(buffer.size());
+  }
+  state.SetBytesProcessed(state.iterations() * kRequest.size());
+}
+BENCHMARK(BM_HttpMessageStreamRewriterRewriteBuffer)
+    ->ArgName("rewrite")
+    ->Arg(0)
+    ->Arg(1);
+
+}  // namespace
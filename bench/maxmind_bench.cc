@@ -0,0 +1,84 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "nekit/utils/maxmind.h"
+
+#include "allocation_counter.h"
+
+using namespace nekit;
+
+namespace {
+
+// The database is copied next to the executable by CMake.
+bool InitializeMaxmind(benchmark::State& state) {
+  static bool initialized = utils::Maxmind::Initalize("GeoLite2-Country.mmdb");
+  if (!initialized) {
+    state.SkipWithError("failed to open GeoLite2-Country.mmdb");
+  }
+  return initialized;
+}
+
+const std::vector<std::string> kAddresses = {
+    "8.8.8.8",       "1.1.1.1",       "114.114.114.114",
+    "127.0.0.1",     "203.0.113.1",   "2001:4860:4860::8888",
+    "93.184.216.34", "202.96.128.86",
+};
+
+void BM_MaxmindLookupAddress(benchmark::State& state) {
+  if (!InitializeMaxmind(state)) {
+    return;
+  }
+
+  std::vector<boost::asio::ip::address> addresses;
+  for (const auto& address : kAddresses) {
+    addresses.push_back(boost::asio::ip::make_address(address));
+  }
+
+  bench::AllocationCounter counter{state};
+  size_t i = 0;
+  for (auto _ : state) {
+    auto result = utils::Maxmind::Lookup(addresses[i++ % addresses.size()]);
+    benchmark::DoNotOptimize(result->country_iso_code());
+  }
+}
+BENCHMARK(BM_MaxmindLookupAddress);
+
+void BM_MaxmindLookupString(benchmark::State& state) {
+  if (!InitializeMaxmind(state)) {
+    return;
+  }
+
+  bench::AllocationCounter counter{state};
+  size_t i = 0;
+  for (auto _ : state) {
+    auto result = utils::Maxmind::Lookup(kAddresses[i++ % kAddresses.size()]);
+    benchmark::DoNotOptimize(result->country_iso_code());
+  }
+}
+BENCHMARK(BM_MaxmindLookupString);
+
+}  // namespace
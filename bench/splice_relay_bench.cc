@@ -0,0 +1,175 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <boost/asio.hpp>
+
+#include "nekit/transport/splice_relay.h"
+#include "nekit/utils/buffer.h"
+#include "nekit/utils/buffer_pool.h"
+#include "nekit/utils/buffer_sequence.h"
+#include "nekit/utils/runloop.h"
+
+#include "allocation_counter.h"
+
+using namespace nekit;
+using boost::asio::ip::tcp;
+
+namespace {
+
+const size_t kTransferSize = 16 * 1024 * 1024;
+
+// client -> local => relay => remote -> server, all over loopback.
+class RelayFixture {
+ public:
+  RelayFixture()
+      : client_{*runloop_.BoostIoContext()},
+        local_{*runloop_.BoostIoContext()},
+        remote_{*runloop_.BoostIoContext()},
+        server_{*runloop_.BoostIoContext()},
+        data_(1024 * 1024, 'a'),
+        read_buffer_(1024 * 1024) {
+    Connect(&client_, &local_);
+    Connect(&remote_, &server_);
+  }
+
+  // Copy the data through `Buffer` the way `TcpSocket` does.
+  void StartBufferRelay() {
+    utils::Buffer buffer{65536};
+    utils::MutableBufferSequence sequence{buffer};
+    local_.async_read_some(
+        sequence, [this, buffer{std::move(buffer)}](
+                      const boost::system::error_code& ec,
+                      size_t bytes_transferred) mutable {
+          if (ec) {
+            return;
+          }
+          buffer.ShrinkBack(buffer.size() - bytes_transferred);
+          utils::ConstBufferSequence sequence{buffer};
+          boost::asio::async_write(
+              remote_, sequence,
+              [this, buffer{std::move(buffer)}](
+                  const boost::system::error_code& ec, size_t) {
+                if (!ec) {
+                  StartBufferRelay();
+                }
+              });
+        });
+  }
+
+  bool StartSpliceRelay() {
+    relay_ = transport::SpliceRelay::Create(&runloop_, &local_, &remote_);
+    if (!relay_) {
+      return false;
+    }
+    relay_->Relay([]() {}, [](utils::Result<void>&&) {});
+    return true;
+  }
+
+  void Transfer() {
+    sent_ = 0;
+    received_ = 0;
+    Send();
+    Receive();
+    while (received_ < kTransferSize) {
+      runloop_.BoostIoContext()->run_one();
+    }
+  }
+
+  utils::Runloop* runloop() { return &runloop_; }
+
+ private:
+  void Connect(tcp::socket* client, tcp::socket* server) {
+    tcp::acceptor acceptor{*runloop_.BoostIoContext(),
+                           {boost::asio::ip::address_v4::loopback(), 0}};
+    client->connect(acceptor.local_endpoint());
+    acceptor.accept(*server);
+  }
+
+  void Send() {
+    if (sent_ == kTransferSize) {
+      return;
+    }
+    boost::asio::async_write(
+        client_, boost::asio::buffer(data_),
+        [this](const boost::system::error_code& ec, size_t bytes_transferred) {
+          if (!ec) {
+            sent_ += bytes_transferred;
+            Send();
+          }
+        });
+  }
+
+  void Receive() {
+    if (received_ == kTransferSize) {
+      return;
+    }
+    server_.async_read_some(
+        boost::asio::buffer(read_buffer_, kTransferSize - received_),
+        [this](const boost::system::error_code& ec, size_t bytes_transferred) {
+          if (!ec) {
+            received_ += bytes_transferred;
+            Receive();
+          }
+        });
+  }
+
+  utils::Runloop runloop_;
+  tcp::socket client_, local_, remote_, server_;
+  std::vector<char> data_, read_buffer_;
+  size_t sent_{0}, received_{0};
+  std::unique_ptr<transport::SpliceRelay> relay_;
+};
+
+void BM_RelayBuffer(benchmark::State& state) {
+  RelayFixture fixture;
+  utils::BufferPool::Scope scope{fixture.runloop()->GetBufferPool()};
+  fixture.StartBufferRelay();
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    fixture.Transfer();
+  }
+  state.SetBytesProcessed(state.iterations() * kTransferSize);
+}
+BENCHMARK(BM_RelayBuffer)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+void BM_RelaySplice(benchmark::State& state) {
+  RelayFixture fixture;
+  if (!fixture.StartSpliceRelay()) {
+    state.SkipWithError("splice is not supported");
+    return;
+  }
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    fixture.Transfer();
+  }
+  state.SetBytesProcessed(state.iterations() * kTransferSize);
+}
+BENCHMARK(BM_RelaySplice)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,80 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "nekit/utils/subnet.h"
+
+#include "allocation_counter.h"
+
+using namespace nekit;
+
+namespace {
+
+using boost::asio::ip::address;
+using boost::asio::ip::address_v4;
+using boost::asio::ip::address_v6;
+
+void BM_SubnetContainsV4(benchmark::State& state) {
+  std::vector<utils::Subnet> subnets;
+  for (uint32_t i = 0; i < 64; i++) {
+    subnets.emplace_back(address_v4{(i + 1) << 24}, 8 + i % 16);
+  }
+  const address target = address_v4{0x7f000001};
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    bool contained = false;
+    for (const auto& subnet : subnets) {
+      contained |= subnet.Contains(target);
+    }
+    benchmark::DoNotOptimize(contained);
+  }
+  state.SetItemsProcessed(state.iterations() * subnets.size());
+}
+BENCHMARK(BM_SubnetContainsV4);
+
+void BM_SubnetContainsV6(benchmark::State& state) {
+  std::vector<utils::Subnet> subnets;
+  for (uint8_t i = 0; i < 64; i++) {
+    address_v6::bytes_type bytes{};
+    bytes[0] = 0x20;
+    bytes[1] = i;
+    subnets.emplace_back(address_v6{bytes}, 16 + i % 64);
+  }
+  const address target = address_v6::loopback();
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    bool contained = false;
+    for (const auto& subnet : subnets) {
+      contained |= subnet.Contains(target);
+    }
+    benchmark::DoNotOptimize(contained);
+  }
+  state.SetItemsProcessed(state.iterations() * subnets.size());
+}
+BENCHMARK(BM_SubnetContainsV6);
+
+}  // namespace
@@ -0,0 +1,96 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "nekit/utils/runloop.h"
+#include "nekit/utils/timer.h"
+
+#include "allocation_counter.h"
+
+using namespace nekit;
+
+namespace {
+
+const uint32_t kTimeout = 300 * 1000;
+
+// Cancelled asio waits complete with an error, run them every now and then
+// like a real runloop would.
+const size_t kPollInterval = 1024;
+
+// Reset one of `state.range(0)` armed idle timeouts per iteration, the way a
+// tunnel does after every read and write.
+template <typename T>
+void BM_TimerReset(benchmark::State& state) {
+  utils::Runloop runloop;
+  std::vector<std::unique_ptr<T>> timers;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    timers.push_back(std::make_unique<T>(&runloop, []() {}));
+    timers.back()->Wait(kTimeout);
+  }
+
+  size_t index = 0;
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    timers[index]->Wait(kTimeout);
+    if (++index % kPollInterval == 0) {
+      runloop.BoostIoContext()->poll();
+    }
+    if (index == timers.size()) {
+      index = 0;
+    }
+  }
+}
+
+// Arm and cancel a timer per iteration, the way a connect timeout is used.
+template <typename T>
+void BM_TimerArmCancel(benchmark::State& state) {
+  utils::Runloop runloop;
+  std::vector<std::unique_ptr<T>> timers;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    timers.push_back(std::make_unique<T>(&runloop, []() {}));
+    timers.back()->Wait(kTimeout);
+  }
+
+  T timer{&runloop, []() {}};
+  size_t count = 0;
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    timer.Wait(5000);
+    timer.Cancel();
+    if (++count % kPollInterval == 0) {
+      runloop.BoostIoContext()->poll();
+    }
+  }
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_TimerReset, utils::Timer)->Arg(1000)->Arg(50000);
+BENCHMARK_TEMPLATE(BM_TimerReset, utils::WheelTimer)->Arg(1000)->Arg(50000);
+BENCHMARK_TEMPLATE(BM_TimerArmCancel, utils::Timer)->Arg(1000)->Arg(50000);
+BENCHMARK_TEMPLATE(BM_TimerArmCancel, utils::WheelTimer)
+    ->Arg(1000)
+    ->Arg(50000);
@@ -0,0 +1,83 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "nekit/utils/trie.h"
+
+#include "allocation_counter.h"
+
+using namespace nekit;
+
+namespace {
+
+std::vector<std::string> Domains(size_t count, const std::string& prefix) {
+  std::vector<std::string> domains;
+  domains.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    domains.push_back(prefix + std::to_string(i) + ".example" +
+                      std::to_string(i % 97) + ".com");
+  }
+  return domains;
+}
+
+void BM_DomainTrieAdd(benchmark::State& state) {
+  const auto domains = Domains(state.range(0), "host");
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    utils::DomainTrie<true> trie;
+    for (const auto& domain : domains) {
+      trie.AddPrefix(domain);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * domains.size());
+}
+BENCHMARK(BM_DomainTrieAdd)->Arg(1000)->Arg(50000);
+
+void BM_DomainTrieMatch(benchmark::State& state) {
+  const auto domains = Domains(state.range(0), "host");
+  // Half of the queries hit the list.
+  auto queries = Domains(512, "host");
+  const auto misses = Domains(512, "miss");
+  for (size_t i = 1; i < queries.size(); i += 2) {
+    queries[i] = misses[i];
+  }
+
+  utils::DomainTrie<true> trie;
+  for (const auto& domain : domains) {
+    trie.AddPrefix(domain);
+  }
+
+  bench::AllocationCounter counter{state};
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        trie.MatchPrefixWith(queries[i++ % queries.size()]));
+  }
+}
+BENCHMARK(BM_DomainTrieMatch)->Arg(1000)->Arg(50000);
+
+}  // namespace
@@ -0,0 +1,269 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <boost/asio.hpp>
+
+#include "nekit/data_flow/http_server_data_flow.h"
+#include "nekit/data_flow/remote_data_flow_interface.h"
+#include "nekit/rule/all_rule.h"
+#include "nekit/rule/rule_manager.h"
+#include "nekit/transport/tcp_listener.h"
+#include "nekit/transport/tcp_socket.h"
+#include "nekit/transport/tunnel.h"
+#include "nekit/utils/buffer_pool.h"
+#include "nekit/utils/runloop.h"
+
+#include "allocation_counter.h"
+
+using namespace nekit;
+using boost::asio::ip::tcp;
+
+namespace {
+
+const size_t kTransferSize = 4 * 1024 * 1024;
+const auto kWriteLatency = std::chrono::microseconds(500);
+
+// A remote hop whose writes complete a fixed latency after the data is handed
+// to the socket, like a hop waiting for its upstream to take the data.
+class DelayedDataFlow : public data_flow::RemoteDataFlowInterface {
+ public:
+  explicit DelayedDataFlow(
+      std::unique_ptr<data_flow::RemoteDataFlowInterface>&& data_flow)
+      : data_flow_{std::move(data_flow)} {}
+
+  utils::Cancelable Read(DataEventHandler handler) override {
+    return data_flow_->Read(handler);
+  }
+
+  utils::Cancelable Write(utils::Buffer&& buffer,
+                          EventHandler handler) override {
+    auto runloop = GetRunloop();
+    return data_flow_->Write(
+        std::move(buffer), [runloop, handler](utils::Result<void>&& result) {
+          auto timer = std::make_shared<boost::asio::steady_timer>(
+              *runloop->BoostIoContext(), kWriteLatency);
+          timer->async_wait([timer, handler, result{std::move(result)}](
+                                const boost::system::error_code&) mutable {
+            handler(std::move(result));
+          });
+        });
+  }
+
+  utils::Cancelable CloseWrite(EventHandler handler) override {
+    return data_flow_->CloseWrite(handler);
+  }
+
+  const data_flow::FlowStateMachine& StateMachine() const override {
+    return data_flow_->StateMachine();
+  }
+
+  data_flow::DataFlowInterface* NextHop() const override {
+    return data_flow_.get();
+  }
+
+  data_flow::DataType FlowDataType() const override {
+    return data_flow_->FlowDataType();
+  }
+
+  std::shared_ptr<utils::Session> Session() const override {
+    return data_flow_->Session();
+  }
+
+  utils::Runloop* GetRunloop() override { return data_flow_->GetRunloop(); }
+
+  utils::Cancelable Connect(std::shared_ptr<utils::Endpoint> endpoint,
+                            EventHandler handler) override {
+    return data_flow_->Connect(endpoint, handler);
+  }
+
+  std::shared_ptr<utils::Endpoint> ConnectingTo() override {
+    return data_flow_->ConnectingTo();
+  }
+
+ private:
+  std::unique_ptr<data_flow::RemoteDataFlowInterface> data_flow_;
+};
+
+// client -> HTTP proxy => tunnel => delayed hop -> echo server, all over
+// loopback, the data echoed back goes through the tunnel again.
+class TunnelFixture {
+ public:
+  TunnelFixture(size_t high_watermark, size_t low_watermark)
+      : listener_{&runloop_,
+                  [](std::unique_ptr<data_flow::LocalDataFlowInterface>&&
+                         data_flow) {
+                    auto session = data_flow->Session();
+                    return std::make_unique<data_flow::HttpServerDataFlow>(
+                        std::move(data_flow), session);
+                  }},
+        rule_manager_{&runloop_},
+        echo_acceptor_{*runloop_.BoostIoContext(),
+                       {boost::asio::ip::address_v4::loopback(), 0}},
+        echo_server_{*runloop_.BoostIoContext()},
+        client_{*runloop_.BoostIoContext()},
+        data_(256 * 1024, 'a'),
+        echo_buffer_(64 * 1024),
+        read_buffer_(64 * 1024) {
+    rule_manager_.AppendRule(std::make_shared<rule::AllRule>(
+        [](std::shared_ptr<utils::Session> session) {
+          return std::make_unique<DelayedDataFlow>(
+              std::make_unique<transport::TcpSocket>(session));
+        }));
+
+    tunnel_manager_.SetTunnelMemoryLimit(0);
+    tunnel_manager_.SetForwardWatermarks(high_watermark, low_watermark);
+
+    listener_.Bind("127.0.0.1", 0);
+    listener_.Accept(
+        [this](utils::Result<
+                   std::unique_ptr<data_flow::LocalDataFlowInterface>>&&
+                   data_flow) {
+          if (data_flow) {
+            tunnel_manager_.Build(*std::move(data_flow), &rule_manager_).Open();
+          }
+        });
+
+    echo_acceptor_.async_accept(echo_server_,
+                                [this](const boost::system::error_code& ec) {
+                                  if (!ec) {
+                                    Echo();
+                                  }
+                                });
+
+    client_.connect(listener_.local_endpoint());
+    std::string request =
+        "CONNECT 127.0.0.1:" +
+        std::to_string(echo_acceptor_.local_endpoint().port()) +
+        " HTTP/1.1\r\n\r\n";
+    boost::asio::write(client_, boost::asio::buffer(request));
+
+    bool connected = false;
+    boost::asio::async_read_until(
+        client_, response_, "\r\n\r\n",
+        [&connected](const boost::system::error_code&, size_t) {
+          connected = true;
+        });
+    RunUntil([&connected]() { return connected; });
+  }
+
+  void Transfer() {
+    sent_ = 0;
+    received_ = 0;
+    Send();
+    Receive();
+    RunUntil([this]() { return received_ == kTransferSize; });
+  }
+
+  utils::Runloop* runloop() { return &runloop_; }
+
+ private:
+  void RunUntil(std::function<bool()> done) {
+    // The context is stopped whenever it runs out of work.
+    runloop_.BoostIoContext()->restart();
+    while (!done()) {
+      runloop_.BoostIoContext()->run_one();
+    }
+  }
+
+  void Echo() {
+    echo_server_.async_read_some(
+        boost::asio::buffer(echo_buffer_),
+        [this](const boost::system::error_code& ec, size_t bytes_transferred) {
+          if (ec) {
+            return;
+          }
+          boost::asio::async_write(
+              echo_server_,
+              boost::asio::buffer(echo_buffer_, bytes_transferred),
+              [this](const boost::system::error_code& ec, size_t) {
+                if (!ec) {
+                  Echo();
+                }
+              });
+        });
+  }
+
+  void Send() {
+    if (sent_ == kTransferSize) {
+      return;
+    }
+    boost::asio::async_write(
+        client_, boost::asio::buffer(data_),
+        [this](const boost::system::error_code& ec, size_t bytes_transferred) {
+          if (!ec) {
+            sent_ += bytes_transferred;
+            Send();
+          }
+        });
+  }
+
+  void Receive() {
+    client_.async_read_some(
+        boost::asio::buffer(read_buffer_),
+        [this](const boost::system::error_code& ec, size_t bytes_transferred) {
+          if (ec) {
+            return;
+          }
+          received_ += bytes_transferred;
+          if (received_ < kTransferSize) {
+            Receive();
+          }
+        });
+  }
+
+  utils::Runloop runloop_;
+  transport::TcpListener listener_;
+  rule::RuleManager rule_manager_;
+  transport::TunnelManager tunnel_manager_;
+  tcp::acceptor echo_acceptor_;
+  tcp::socket echo_server_, client_;
+  boost::asio::streambuf response_;
+  std::vector<char> data_, echo_buffer_, read_buffer_;
+  size_t sent_{0}, received_{0};
+};
+
+// The first argument is the high watermark, 0 forwards one buffer at a time.
+void BM_TunnelEcho(benchmark::State& state) {
+  TunnelFixture fixture(state.range(0), state.range(0) / 4);
+  utils::BufferPool::Scope scope{fixture.runloop()->GetBufferPool()};
+
+  bench::AllocationCounter counter{state};
+  for (auto _ : state) {
+    fixture.Transfer();
+  }
+  state.SetBytesProcessed(state.iterations() * kTransferSize);
+}
+BENCHMARK(BM_TunnelEcho)
+    ->Arg(0)
+    ->Arg(128 * 1024)
+    ->Arg(1024 * 1024)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -55,6 +55,9 @@ class LibnekitConan(ConanFile):
         if tools.get_env("CONAN_RUN_TESTS", True):
             self.requires("gtest/1.8.1@bincrafters/stable")
 
+        if tools.get_env("NE_BUILD_BENCHMARK", False):
+            self.requires("benchmark/1.5.0")
+
 
     def _cmake(self):
         cmake = CMake(self)
@@ -62,6 +65,8 @@ class LibnekitConan(ConanFile):
             cmake.definitions["NE_ENABLE_TEST"]="ON"
         else:
             cmake.definitions["NE_ENABLE_TEST"]="OFF"
+        if tools.get_env("NE_BUILD_BENCHMARK", False):
+            cmake.definitions["NE_BUILD_BENCHMARK"]="ON"
         return cmake
 
     def build(self):
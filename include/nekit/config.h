@@ -22,10 +22,139 @@
 
 #pragma once
 
+// `TcpSocket` starts reading with `NEKIT_TCP_SOCKET_READ_SIZE` bytes. The size
+// doubles when a read fills the buffer and halves when a read uses less than a
+// quarter of it, between the min and max read size. The space reserved for
+// other data flows is included in the read size.
 #ifndef NEKIT_TCP_SOCKET_READ_SIZE
 #define NEKIT_TCP_SOCKET_READ_SIZE 8192
 #endif
 
+#ifndef NEKIT_TCP_SOCKET_MIN_READ_SIZE
+#define NEKIT_TCP_SOCKET_MIN_READ_SIZE 2048
+#endif
+
+#ifndef NEKIT_TCP_SOCKET_MAX_READ_SIZE
+#define NEKIT_TCP_SOCKET_MAX_READ_SIZE 65536
+#endif
+
+// Chunks no larger than `NEKIT_BUFFER_POOL_MAX_CHUNK_SIZE` are recycled by the
+// buffer pool in power of two size classes, larger ones are allocated from heap
+// directly.
+#ifndef NEKIT_BUFFER_POOL_MIN_CHUNK_SIZE
+#define NEKIT_BUFFER_POOL_MIN_CHUNK_SIZE 64
+#endif
+
+#ifndef NEKIT_BUFFER_POOL_MAX_CHUNK_SIZE
+#define NEKIT_BUFFER_POOL_MAX_CHUNK_SIZE 65536
+#endif
+
+#ifndef NEKIT_BUFFER_POOL_SLAB_SIZE
+#define NEKIT_BUFFER_POOL_SLAB_SIZE 262144
+#endif
+
+// Slab size used when the pool is backed by transparent huge pages.
+#ifndef NEKIT_BUFFER_POOL_HUGE_PAGE_SLAB_SIZE
+#define NEKIT_BUFFER_POOL_HUGE_PAGE_SLAB_SIZE 2097152
+#endif
+
+#ifndef NEKIT_BUFFER_POOL_USE_HUGE_PAGE
+#define NEKIT_BUFFER_POOL_USE_HUGE_PAGE 0
+#endif
+
+// `Buffer` builds an offset index of its chunks once a lookup has to walk
+// more than this many chunks.
+#ifndef NEKIT_BUFFER_INDEX_THRESHOLD
+#define NEKIT_BUFFER_INDEX_THRESHOLD 32
+#endif
+
+// When compaction is enabled on a `Buffer`, adjacent chunks smaller than
+// this are coalesced once there are more chunks than the limit.
+#ifndef NEKIT_BUFFER_COMPACTION_CHUNK_SIZE
+#define NEKIT_BUFFER_COMPACTION_CHUNK_SIZE 1024
+#endif
+
+#ifndef NEKIT_BUFFER_COMPACTION_CHUNK_COUNT
+#define NEKIT_BUFFER_COMPACTION_CHUNK_COUNT 16
+#endif
+
+// The buffer memory one tunnel can hold before it stops reading, and the
+// default limit of all the tunnels in an instance. 0 means unlimited.
+#ifndef NEKIT_TUNNEL_MEMORY_LIMIT
+#define NEKIT_TUNNEL_MEMORY_LIMIT 262144
+#endif
+
+#ifndef NEKIT_INSTANCE_MEMORY_LIMIT
+#define NEKIT_INSTANCE_MEMORY_LIMIT 0
+#endif
+
+// A tunnel keeps reading from one side while the data read before is being
+// written to the other side, until the bytes not written yet reach the high
+// watermark. It reads again once they drop to the low watermark. A high
+// watermark of 0 disables pipelining, the next read waits for the write.
+#ifndef NEKIT_TUNNEL_FORWARD_HIGH_WATERMARK
+#define NEKIT_TUNNEL_FORWARD_HIGH_WATERMARK 131072
+#endif
+
+#ifndef NEKIT_TUNNEL_FORWARD_LOW_WATERMARK
+#define NEKIT_TUNNEL_FORWARD_LOW_WATERMARK 32768
+#endif
+
+// How often a draining proxy manager reports the tunnels left, in
+// milliseconds.
+#ifndef NEKIT_DRAIN_REPORT_INTERVAL
+#define NEKIT_DRAIN_REPORT_INTERVAL 5000
+#endif
+
+// `TcpSocket` accepts more writes until this many writes or bytes are queued,
+// the queued buffers are sent together with one gather write.
+#ifndef NEKIT_TCP_SOCKET_WRITE_QUEUE_DEPTH
+#define NEKIT_TCP_SOCKET_WRITE_QUEUE_DEPTH 64
+#endif
+
+#ifndef NEKIT_TCP_SOCKET_WRITE_QUEUE_SIZE
+#define NEKIT_TCP_SOCKET_WRITE_QUEUE_SIZE 262144
+#endif
+
+// With `SO_ZEROCOPY` enabled, `TcpSocket` sends the queued data with
+// `MSG_ZEROCOPY` when there are at least this many bytes. Smaller sends are
+// cheaper to copy than to track.
+#ifndef NEKIT_TCP_SOCKET_ZERO_COPY_THRESHOLD
+#define NEKIT_TCP_SOCKET_ZERO_COPY_THRESHOLD 16384
+#endif
+
+// `TcpListener` accepts at most this many connections each time it wakes up
+// before letting other events run.
+#ifndef NEKIT_TCP_LISTENER_ACCEPT_BATCH_SIZE
+#define NEKIT_TCP_LISTENER_ACCEPT_BATCH_SIZE 32
+#endif
+
+// Relay the data of a tunnel with `splice()` when both sides are plain TCP
+// sockets, Linux only. The relay moves at most `NEKIT_SPLICE_RELAY_SIZE`
+// bytes at a time and yields to the runloop every
+// `NEKIT_SPLICE_RELAY_BATCH_COUNT` moves.
+#ifndef NEKIT_TUNNEL_USE_SPLICE
+#define NEKIT_TUNNEL_USE_SPLICE 1
+#endif
+
+#ifndef NEKIT_SPLICE_RELAY_SIZE
+#define NEKIT_SPLICE_RELAY_SIZE 65536
+#endif
+
+#ifndef NEKIT_SPLICE_RELAY_BATCH_COUNT
+#define NEKIT_SPLICE_RELAY_BATCH_COUNT 16
+#endif
+
+// The tick in milliseconds and the number of slots of the timer wheel of each
+// runloop. The slot count must be a power of two.
+#ifndef NEKIT_TIMER_WHEEL_TICK
+#define NEKIT_TIMER_WHEEL_TICK 10
+#endif
+
+#ifndef NEKIT_TIMER_WHEEL_SLOT_COUNT
+#define NEKIT_TIMER_WHEEL_SLOT_COUNT 1024
+#endif
+
 // There is no good choice there, the server defaults (e.g., Apache, nginx) are
 // usually quite large and only define the maximum length of each line instead
 // of the whole header. In Node.js it is defined as 80 * 1024. Enlarge it if the
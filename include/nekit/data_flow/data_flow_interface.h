@@ -30,6 +30,7 @@
 
 #include "../utils/async_interface.h"
 #include "../utils/buffer.h"
+#include "../utils/buffer_reserve_size.h"
 #include "../utils/cancelable.h"
 #include "../utils/result.h"
 #include "../utils/session.h"
@@ -67,6 +68,36 @@ class DataFlowInterface : public utils::AsyncInterface,
   virtual DataType FlowDataType() const = 0;
 
   virtual std::shared_ptr<utils::Session> Session() const = 0;
+
+  // Whether the data flow passes the data between the previous and the next
+  // hop unchanged from now on, then the data can be read from and written to
+  // the next hop directly.
+  virtual bool IsPassThrough() const { return false; }
+
+  // The space this data flow needs before and after the data passed to
+  // `Write`, so it can encapsulate the data in place.
+  virtual utils::BufferReserveSize WriteReserveSize() const {
+    return utils::BufferReserveSize{0, 0};
+  }
+
+  // The space needed by this data flow and all the next hops.
+  utils::BufferReserveSize ChainWriteReserveSize() const {
+    utils::BufferReserveSize reserve_size{0, 0};
+    for (const DataFlowInterface* flow = this; flow; flow = flow->NextHop()) {
+      reserve_size += flow->WriteReserveSize();
+    }
+    return reserve_size;
+  }
+
+  // Ask the data flow to reserve space before and after the data of the
+  // buffers returned by `Read`. The request is passed to the next hop by
+  // default, the data flow allocating the buffers should override it.
+  virtual void SetReadReserveSize(utils::BufferReserveSize reserve_size) {
+    auto next_hop = NextHop();
+    if (next_hop) {
+      next_hop->SetReadReserveSize(reserve_size);
+    }
+  }
 };
 }  // namespace data_flow
 }  // namespace nekit
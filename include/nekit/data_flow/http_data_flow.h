@@ -70,6 +70,8 @@ class HttpDataFlow : public RemoteDataFlowInterface {
 
   DataFlowInterface* NextHop() const override;
 
+  bool IsPassThrough() const override;
+
   DataType FlowDataType() const override;
 
   std::shared_ptr<utils::Session> Session() const override;
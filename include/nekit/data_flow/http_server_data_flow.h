@@ -56,6 +56,8 @@ class HttpServerDataFlow : public LocalDataFlowInterface {
 
   DataFlowInterface* NextHop() const override;
 
+  bool IsPassThrough() const override;
+
   DataType FlowDataType() const override;
 
   std::shared_ptr<utils::Session> Session() const override;
@@ -64,6 +64,8 @@ class Socks5DataFlow : public RemoteDataFlowInterface {
 
   DataFlowInterface* NextHop() const override;
 
+  bool IsPassThrough() const override;
+
   DataType FlowDataType() const override;
 
   std::shared_ptr<utils::Session> Session() const override;
@@ -61,6 +61,8 @@ class Socks5ServerDataFlow final : public LocalDataFlowInterface {
 
   DataFlowInterface* NextHop() const override;
 
+  bool IsPassThrough() const override;
+
   DataType FlowDataType() const override;
 
   std::shared_ptr<utils::Session> Session() const override;
@@ -73,7 +73,7 @@ class SpeedDataFlow : public RemoteDataFlowInterface {
 
   std::shared_ptr<utils::Endpoint> target_endpoint_;
 
-  std::list<utils::Timer> connect_timers_;
+  std::list<utils::WheelTimer> connect_timers_;
   utils::Cancelable connect_cancelable_;
 
   size_t current_active_connection_;
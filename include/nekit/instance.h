@@ -22,33 +22,99 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <vector>
 
 #include <boost/noncopyable.hpp>
 
+#include "config.h"
 #include "proxy_manager.h"
 #include "utils/async_interface.h"
+#include "utils/memory_budget.h"
 #include "utils/runloop.h"
 
 namespace nekit {
+// The stats summed over all the workers of an instance.
+struct InstanceStats {
+  size_t tunnels{0};
+  // The buffer memory held by the tunnels, the peak is the sum of the peak of
+  // each worker.
+  size_t memory{0};
+  size_t peak_memory{0};
+};
+
+// An instance runs `worker_count` runloops, each on its own thread. The
+// first one runs on the thread calling `Run()`.
+//
+// Nothing is shared between the workers, the proxy managers, rule managers
+// and resolvers are created for each worker with its runloop, usually by
+// `AddProxyManagers()`. The rules can
+// be shared by the rule managers of all the workers as long as the data flows
+// they create only depend on the session. Use `ShardedTcpListener` to accept
+// connections on the same address with every worker.
 class Instance : public utils::AsyncInterface, private boost::noncopyable {
  public:
-  explicit Instance(std::string name);
+  using StatsHandler = std::function<void(InstanceStats)>;
+  // Create a proxy manager, with its rule manager and resolver, running on
+  // `runloop` of worker `index`, e.g., listening on shard `index` of a
+  // `ShardedTcpListener`.
+  using ProxyManagerFactory = std::function<std::unique_ptr<ProxyManager>(
+      utils::Runloop *runloop, size_t index)>;
+
+  explicit Instance(std::string name, size_t worker_count = 1);
 
+  size_t worker_count() const;
+  utils::Runloop *GetWorkerRunloop(size_t index);
+
+  // The proxy manager belongs to the worker running its runloop.
   void AddProxyManager(std::unique_ptr<ProxyManager> &&proxy_manager);
+  // Call `factory` once for every worker and add the proxy manager it
+  // creates to that worker.
+  void AddProxyManagers(ProxyManagerFactory factory);
+
+  // Limit the buffer memory held by all the tunnels, 0 means unlimited. The
+  // limit is split evenly between the workers.
+  void SetMemoryLimit(size_t limit);
+  const utils::MemoryBudget &GetMemoryBudget(size_t worker = 0) const;
+
+  // Pin the thread of worker i to CPU i modulo the number of CPUs. Linux
+  // only. Must be called before `Run()`.
+  void SetPinWorkers(bool pin_workers);
+
+  // Collect the stats from every worker on its own thread, `handler` is
+  // called on the runloop of the first worker.
+  void CollectStats(StatsHandler handler);
 
   void Run();
+  // Can be called from any thread.
   void Stop();
+  // Stop accepting new connections and stop once the open tunnels finish or
+  // `timeout` milliseconds later, each worker stops on its own. Can be called
+  // from any thread.
+  void Drain(uint32_t timeout);
   void Reset();
 
+  // The runloop of the first worker.
   utils::Runloop *GetRunloop() override;
 
  private:
+  struct Worker {
+    utils::Runloop runloop;
+
+    // Must outlive the tunnels charged to it.
+    utils::MemoryBudget memory_budget;
+
+    std::vector<std::unique_ptr<ProxyManager>> proxy_managers;
+  };
+
+  void RunWorker(size_t index);
+
   std::string name_;
-  utils::Runloop runloop_;
 
-  std::vector<std::unique_ptr<ProxyManager>> proxy_managers_;
+  std::vector<std::unique_ptr<Worker>> workers_;
 
+  bool pin_workers_{false};
   bool ready_{true};
 };
 }  // namespace nekit
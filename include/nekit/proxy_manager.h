@@ -22,10 +22,15 @@
 
 #pragma once
 
+#include <functional>
+
+#include "config.h"
 #include "transport/listener_interface.h"
 #include "transport/tunnel.h"
 #include "utils/async_interface.h"
+#include "utils/cancelable.h"
 #include "utils/resolver_interface.h"
+#include "utils/timer.h"
 
 namespace nekit {
 class ProxyManager : public utils::AsyncInterface {
@@ -36,17 +41,35 @@ class ProxyManager : public utils::AsyncInterface {
   void SetResolver(std::unique_ptr<utils::ResolverInterface> &&resolver);
   void AddListener(std::unique_ptr<transport::ListenerInterface> &&listener);
 
+  // The tunnels created by the manager are charged to `memory_budget`.
+  void SetMemoryBudget(utils::MemoryBudget *memory_budget);
+  void SetTunnelMemoryLimit(size_t limit);
+
+  size_t tunnel_count() const;
+
   void Run();
   void Stop();
 
+  // Stop accepting new connections and let the open tunnels finish. The
+  // tunnels left after `timeout` milliseconds are closed. `handler` is called
+  // once there is no tunnel left, the manager is not stopped yet.
+  void Drain(uint32_t timeout, std::function<void()> handler);
+
   utils::Runloop *GetRunloop() override;
 
  private:
+  void ReportDrain();
+  void FinishDrain();
+
   std::unique_ptr<rule::RuleManager> rule_manager_;
   std::unique_ptr<utils::ResolverInterface> resolver_;
   std::vector<std::unique_ptr<transport::ListenerInterface>> listeners_;
   transport::TunnelManager tunnel_manager_;
 
   utils::Runloop *runloop_;
+
+  std::function<void()> drain_handler_;
+  utils::Cancelable drain_cancelable_;
+  utils::Timer drain_timer_, drain_report_timer_;
 };
 }  // namespace nekit
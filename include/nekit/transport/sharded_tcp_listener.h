@@ -0,0 +1,88 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "../utils/result.h"
+#include "../utils/runloop.h"
+#include "listener_interface.h"
+#include "socket_options.h"
+#include "tcp_listener.h"
+
+namespace nekit {
+namespace transport {
+
+// A group of `TcpListener`s bound to the same address with `SO_REUSEPORT`, one
+// for each runloop, so every runloop accepts its own share of the connections
+// without contending on one accept queue.
+//
+// Each shard is handed to the `ProxyManager` of its runloop with `Shard()`.
+class ShardedTcpListener final
+    : public std::enable_shared_from_this<ShardedTcpListener>,
+      private boost::noncopyable {
+ public:
+  ShardedTcpListener(std::vector<utils::Runloop*> runloops,
+                     ListenerInterface::DataFlowHandler handler);
+
+  // `SO_REUSEPORT` is always enabled on top of `options`. Must be called
+  // before `Bind`.
+  void SetSocketOptions(const SocketOptions& options);
+  void SetBacklog(int backlog);
+
+  // Steer each connection to the shard with the index of the CPU handling it
+  // modulo the number of shards, instead of by the hash of the connection.
+  // Together with pinning the runloop of shard i to CPU i and the receive
+  // queue interrupts of the NIC spread across the same CPUs, a connection is
+  // processed on one CPU from the NIC to the proxy. Linux only.
+  void SetSteerByCpu(bool steer_by_cpu);
+
+  // The port must not be 0 since all the shards have to share it.
+  utils::Result<void> Bind(std::string ip, uint16_t port);
+
+  size_t shard_count() const;
+
+  // The listener of shard `index`, it must be used on the runloop of the
+  // shard. The group is kept alive by the shards.
+  std::unique_ptr<ListenerInterface> Shard(size_t index);
+
+  // The stats of every shard, showing how even the connections are spread.
+  // Can be called from any thread, so the queue stats are left out since
+  // they can only be read on the runloop of each shard.
+  std::vector<TcpListenerStats> GetStats();
+
+ private:
+  class ShardListener;
+
+  utils::Result<void> AttachCpuSteering();
+
+  std::vector<std::unique_ptr<TcpListener>> listeners_;
+  bool steer_by_cpu_{false};
+};
+}  // namespace transport
+}  // namespace nekit
@@ -0,0 +1,106 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/optional.hpp>
+
+namespace nekit {
+namespace transport {
+
+/**
+ * @brief A set of TCP socket options applied when a socket is connected or
+ * accepted.
+ *
+ * Only the options set explicitly are applied. The options not supported by
+ * the platform are skipped, and failures are logged instead of failing the
+ * connection. Share one profile between the sockets of the same kind of
+ * traffic, e.g., `TCP_NODELAY` and a low `TCP_NOTSENT_LOWAT` for interactive
+ * tunnels, large buffers for bulk tunnels.
+ */
+class SocketOptions {
+ public:
+  SocketOptions& set_no_delay(bool no_delay);
+  // Setting the buffer sizes disables the automatic tuning of the system.
+  SocketOptions& set_receive_buffer_size(int size);
+  SocketOptions& set_send_buffer_size(int size);
+  // Limit the unsent data in the send buffer so the data stays in the write
+  // queue where it can still be coalesced. Linux and macOS only.
+  SocketOptions& set_not_sent_low_watermark(int size);
+  // Enable keepalive, the intervals are in seconds.
+  SocketOptions& set_keep_alive(int idle, int interval, int count);
+  // Linux only. The system may turn it off again, so it only affects the
+  // beginning of the connection.
+  SocketOptions& set_quick_ack(bool quick_ack);
+  // Abort the connection if the sent data is not acknowledged in `timeout`
+  // milliseconds. Linux only.
+  SocketOptions& set_user_timeout(unsigned int timeout);
+  // TCP Fast Open on the listening socket, at most `queue_length` connections
+  // can be pending with data in the SYN. Only applied to listeners.
+  SocketOptions& set_fast_open_queue_length(int queue_length);
+  // Defer connecting until the first write so the data is sent in the SYN if
+  // the server supports TCP Fast Open, otherwise the connection falls back to
+  // the normal handshake. Only applied to connecting sockets, Linux only.
+  SocketOptions& set_fast_open_connect(bool fast_open_connect);
+
+  // Allow sending large writes without copying with `MSG_ZEROCOPY`. The
+  // memory is held until the system notifies that it is no longer needed.
+  // Linux only.
+  SocketOptions& set_zero_copy(bool zero_copy);
+
+  // Let several listening sockets bind to the same address, the system
+  // distributes the new connections among them. Only applied to listeners.
+  SocketOptions& set_reuse_port(bool reuse_port);
+
+  bool fast_open_enabled() const;
+
+  void Apply(boost::asio::ip::tcp::socket* socket) const;
+  // The accepted sockets inherit the options from the listening socket on
+  // most platforms, notably the buffer sizes which must be set before the
+  // connection is established to take effect on the TCP window scale.
+  void Apply(boost::asio::ip::tcp::acceptor* acceptor) const;
+
+ private:
+  struct KeepAlive {
+    int idle;
+    int interval;
+    int count;
+  };
+
+  template <typename Socket>
+  void DoApply(Socket* socket) const;
+
+  boost::optional<bool> no_delay_;
+  boost::optional<int> receive_buffer_size_;
+  boost::optional<int> send_buffer_size_;
+  boost::optional<int> not_sent_low_watermark_;
+  boost::optional<KeepAlive> keep_alive_;
+  boost::optional<bool> quick_ack_;
+  boost::optional<unsigned int> user_timeout_;
+  boost::optional<int> fast_open_queue_length_;
+  boost::optional<bool> fast_open_connect_;
+  boost::optional<bool> zero_copy_;
+  boost::optional<bool> reuse_port_;
+};
+}  // namespace transport
+}  // namespace nekit
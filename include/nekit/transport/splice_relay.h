@@ -0,0 +1,99 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include <boost/asio.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "../data_flow/data_flow_interface.h"
+#include "../utils/cancelable.h"
+#include "../utils/result.h"
+#include "../utils/runloop.h"
+
+namespace nekit {
+namespace transport {
+
+/**
+ * @brief Relay the data between two TCP sockets with `splice()`.
+ *
+ * The data is moved through a pipe in the kernel and never copied to the
+ * userspace. It is only available on Linux, `Create` returns `nullptr` on
+ * other platforms.
+ */
+class SpliceRelay final : private boost::noncopyable {
+ public:
+  using EventHandler = std::function<void(utils::Result<void>&&)>;
+
+  // Return `nullptr` if the relay is not supported or the pipes can't be
+  // created, the data should be forwarded with `Buffer` then.
+  static std::unique_ptr<SpliceRelay> Create(
+      utils::Runloop* runloop, boost::asio::ip::tcp::socket* local,
+      boost::asio::ip::tcp::socket* remote);
+
+  // Return the socket of `flow` if all the data flows in the chain pass the
+  // data through to a `TcpSocket`.
+  static boost::asio::ip::tcp::socket* FindSocket(
+      data_flow::DataFlowInterface* flow);
+
+  ~SpliceRelay();
+
+  // Relay the data in both directions until both reach EOF or any error
+  // happens. `progress_handler` is called whenever some data is relayed.
+  // Releasing the relay cancels it.
+  void Relay(std::function<void()> progress_handler, EventHandler handler);
+
+  uint64_t relayed_bytes() const;
+
+ private:
+  struct Direction {
+    boost::asio::ip::tcp::socket* from;
+    boost::asio::ip::tcp::socket* to;
+    int pipe[2]{-1, -1};
+    // The data read into the pipe but not written yet.
+    size_t pending{0};
+    bool eof{false};
+    bool finished{false};
+  };
+
+  SpliceRelay(utils::Runloop* runloop, boost::asio::ip::tcp::socket* local,
+              boost::asio::ip::tcp::socket* remote);
+
+  void Pump(Direction* direction);
+  void Wait(Direction* direction, boost::asio::ip::tcp::socket* socket,
+            boost::asio::socket_base::wait_type type);
+  void Finish(utils::Result<void>&& result);
+
+  utils::Runloop* runloop_;
+  Direction directions_[2];
+  uint64_t relayed_bytes_{0};
+
+  std::function<void()> progress_handler_;
+  EventHandler handler_;
+  utils::Cancelable cancelable_;
+};
+}  // namespace transport
+}  // namespace nekit
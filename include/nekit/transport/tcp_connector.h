@@ -31,6 +31,7 @@
 #include "../utils/device.h"
 #include "../utils/endpoint.h"
 #include "../utils/result.h"
+#include "socket_options.h"
 
 namespace nekit {
 namespace transport {
@@ -57,6 +58,9 @@ class TcpConnector : public utils::AsyncInterface {
 
   void Bind(std::shared_ptr<utils::DeviceInterface> device);
 
+  // Apply `options` to the socket before connecting.
+  void SetSocketOptions(std::shared_ptr<const SocketOptions> options);
+
   utils::Runloop* GetRunloop() override;
 
  private:
@@ -68,6 +72,7 @@ class TcpConnector : public utils::AsyncInterface {
   std::shared_ptr<utils::Endpoint> endpoint_;
   uint16_t port_;
   std::shared_ptr<utils::DeviceInterface> device_;
+  std::shared_ptr<const SocketOptions> socket_options_;
 
   utils::Runloop* runloop_;
 
@@ -22,35 +22,96 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <system_error>
 
 #include <boost/asio.hpp>
 #include <boost/noncopyable.hpp>
 
+#include "../config.h"
+#include "../utils/cancelable.h"
 #include "listener_interface.h"
+#include "socket_options.h"
 
 namespace nekit {
 namespace transport {
 
+struct TcpListenerStats {
+  uint64_t accepted{0};
+  // The times the listener woke up to accept connections, and the times it
+  // accepted a full batch so more connections were likely waiting.
+  uint64_t batches{0};
+  uint64_t full_batches{0};
+  uint64_t errors{0};
+  // The connections waiting to be accepted and the size of the accept queue,
+  // new connections are dropped once the queue is full. Linux only.
+  uint32_t queue_length{0};
+  uint32_t backlog{0};
+};
+
 class TcpListener : public ListenerInterface, private boost::noncopyable {
  public:
   TcpListener(utils::Runloop* runloop, DataFlowHandler handler);
+  ~TcpListener();
+
+  // Apply `options` to the listening socket and every accepted socket. Must be
+  // called before `Bind` to affect the listening socket.
+  void SetSocketOptions(std::shared_ptr<const SocketOptions> options);
+
+  // The size of the accept queue, `SOMAXCONN` by default. Must be called
+  // before `Bind`.
+  void SetBacklog(int backlog);
 
   utils::Result<void> Bind(std::string ip, uint16_t port);
   utils::Result<void> Bind(boost::asio::ip::address ip, uint16_t port);
 
+  // The address the listener is bound to, with the port chosen by the system
+  // if it was bound to port 0.
+  boost::asio::ip::tcp::endpoint local_endpoint() const;
+
   void Accept(EventHandler handler) override;
 
   void Close() override;
 
   utils::Runloop* GetRunloop() override;
 
+  // The counters can be read from any thread, the queue stats only on the
+  // runloop thread.
+  TcpListenerStats GetStats();
+
+  friend class ShardedTcpListener;
+
  private:
+  void WaitForAccept(EventHandler handler);
+  // Accept the pending connections until there is none or a batch is
+  // accepted.
+  void AcceptBatch(EventHandler handler);
+  // Accept one connection to `socket_` without blocking.
+  void AcceptSocket(boost::system::error_code* ec);
+  void HandleSocket(EventHandler handler);
+  // The stats without the queue stats, safe on any thread.
+  TcpListenerStats GetCounterStats() const;
+
   boost::asio::ip::tcp::acceptor acceptor_;
   boost::asio::ip::tcp::socket socket_;
+  boost::asio::ip::tcp::endpoint endpoint_;
   utils::Runloop* runloop_;
 
   DataFlowHandler handler_;
+  std::shared_ptr<const SocketOptions> socket_options_;
+  int backlog_{boost::asio::socket_base::max_listen_connections};
+
+  struct Counters {
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> full_batches{0};
+    std::atomic<uint64_t> errors{0};
+  };
+
+  Counters counters_;
+  utils::Cancelable accept_cancelable_;
 };
 }  // namespace transport
 }  // namespace nekit
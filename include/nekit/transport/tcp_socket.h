@@ -22,16 +22,20 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <system_error>
-#include <vector>
 
 #include <boost/asio.hpp>
 #include <boost/noncopyable.hpp>
 #include "../third_party/hedley/hedley.h"
 
+#include "../config.h"
 #include "../data_flow/local_data_flow_interface.h"
 #include "../data_flow/remote_data_flow_interface.h"
+#include "socket_options.h"
 #include "tcp_connector.h"
 #include "tcp_listener.h"
 
@@ -60,13 +64,43 @@ class TcpErrorCategory : public utils::ErrorCategory {
 
 NE_DEFINE_NEW_ERROR_CODE(Tcp)
 
+// Counters of all the TCP sockets in the process.
+struct TcpSocketStats {
+  // Connections deferred to send the first write in the SYN.
+  std::atomic<uint64_t> fast_open_connects{0};
+  // Deferred connections whose data in the SYN was acknowledged, the others
+  // fell back to sending the data after the handshake.
+  std::atomic<uint64_t> fast_open_syn_data_acked{0};
+  // Reads and writes attempted before waiting for the socket to be ready, and
+  // the ones completed without waiting. A read that misses costs a failed
+  // system call, the next reads wait until one completes through the wait.
+  std::atomic<uint64_t> speculative_reads{0};
+  std::atomic<uint64_t> speculative_read_hits{0};
+  std::atomic<uint64_t> speculative_read_misses{0};
+  std::atomic<uint64_t> speculative_writes{0};
+  std::atomic<uint64_t> speculative_write_hits{0};
+  // Accepted connections with data in the SYN.
+  std::atomic<uint64_t> fast_open_accepts{0};
+  // Bytes sent with `MSG_ZEROCOPY` that the system did not copy.
+  std::atomic<uint64_t> zero_copy_bytes{0};
+  // All the other bytes sent, including the zero copy sends the system fell
+  // back to copying, e.g., on loopback.
+  std::atomic<uint64_t> copied_bytes{0};
+};
+
 class TcpSocket final : public data_flow::LocalDataFlowInterface,
                         public data_flow::RemoteDataFlowInterface {
  public:
-  explicit TcpSocket(std::shared_ptr<utils::Session> session);
+  // The `options` are applied when connecting, they are usually provided by
+  // the rule handler creating the socket.
+  explicit TcpSocket(std::shared_ptr<utils::Session> session,
+                     std::shared_ptr<const SocketOptions> options = nullptr);
   ~TcpSocket();
 
   HEDLEY_WARN_UNUSED_RESULT utils::Cancelable Read(DataEventHandler) override;
+  // More writes can be submitted before the previous ones complete as long as
+  // the state machine is writable, i.e., the write queue is not full. The
+  // handlers are called in order.
   HEDLEY_WARN_UNUSED_RESULT utils::Cancelable Write(utils::Buffer&&,
                                                     EventHandler) override;
 
@@ -91,22 +125,133 @@ class TcpSocket final : public data_flow::LocalDataFlowInterface,
 
   std::shared_ptr<utils::Endpoint> ConnectingTo() override;
 
+  void SetReadReserveSize(utils::BufferReserveSize reserve_size) override;
+
+  // The underlying boost socket, used to relay the data in the kernel. Do
+  // not read from or write to it while an operation is in progress.
+  boost::asio::ip::tcp::socket* BoostSocket();
+
+  // The number of writes not completed yet.
+  size_t write_queue_depth() const;
+  // The bytes submitted to `Write` but not sent yet.
+  size_t bytes_in_flight() const;
+
+  // Defer sending the queued data to the end of the current runloop turn, so
+  // the writes submitted in the same turn are sent together. Like TCP_CORK,
+  // but the data is never held longer than one turn.
+  void SetCork(bool cork);
+
+  static const TcpSocketStats& Stats();
+
   friend class TcpListener;
 
  private:
   explicit TcpSocket(boost::asio::ip::tcp::socket&& socket,
                      std::shared_ptr<utils::Session> session);
 
+  // Wait until the socket is readable before allocating the buffer, so an
+  // idle connection holds no memory for reading.
+  void WaitForRead(DataEventHandler handler);
+  // Read without blocking, return `false` if there is no data yet. Otherwise
+  // `buffer` holds the data read or `ec` is set. The buffer is only allocated
+  // once there is data to read.
+  bool TryRead(utils::Buffer* buffer, boost::system::error_code* ec);
+  void FinishRead(utils::Buffer&& buffer, const boost::system::error_code& ec,
+                  DataEventHandler handler);
+  bool EnsureNonBlocking(boost::system::error_code* ec);
+  void ReportReadError(const boost::system::error_code& ec,
+                       DataEventHandler handler);
+  // The buffer size of the next read, the read size minus the reserved
+  // space.
+  size_t ReadBufferSize() const;
+  // Grow the read size for bulk transfer and shrink it for interactive
+  // traffic.
+  void AdaptReadSize(size_t bytes_transferred, size_t buffer_size);
+
+  struct PendingWrite {
+    size_t size;
+    EventHandler handler;
+    utils::Cancelable cancelable;
+  };
+
+  void ScheduleFlush();
+  // Send all the queued data with one gather write.
+  void Flush();
+  // Drop the sent data from `buffer`, leaving the data not sent yet.
+  void ConsumeSent(utils::Buffer* buffer, size_t bytes_transferred,
+                   bool zero_copy);
+  void FinishFlush(utils::Buffer&& buffer, bool zero_copy,
+                   const boost::system::error_code& ec,
+                   size_t bytes_transferred);
+  void CompleteWrites(size_t bytes_transferred);
+  void ReportWriteError(const boost::system::error_code& ec);
+  // Mark the socket not writable when the write queue is full.
+  void UpdateWritable();
+  void DoCloseWrite();
+
+  enum class FastOpenState { None, Deferred, Sent };
+
+  // Send the SYN of a deferred connection if there is nothing to write yet,
+  // e.g., the server talks first.
+  void StartDeferredConnect();
+  // Whether the data in the SYN was acknowledged. Linux only.
+  bool IsSynDataAcked();
+  void CountFastOpenAccept();
+
+  // The data sent with `MSG_ZEROCOPY`, held until the system notifies it is
+  // no longer used.
+  struct ZeroCopyWrite {
+    uint32_t id;
+    bool completed;
+    utils::Buffer buffer;
+  };
+
+  // Keep the socket and the buffers after the `TcpSocket` is released until
+  // all the zero copy writes complete.
+  struct ZeroCopyLinger {
+    boost::asio::ip::tcp::socket socket;
+    std::deque<ZeroCopyWrite> writes;
+  };
+
+  enum class ZeroCopyState { Unknown, Enabled, Disabled };
+
+  bool ShouldZeroCopy(size_t size);
+  void WaitForZeroCopyCompletion();
+  static void WaitForZeroCopyLinger(std::shared_ptr<ZeroCopyLinger> linger);
+  // Read the notifications from the error queue and release the completed
+  // writes, return whether any notification is read.
+  static bool ReapZeroCopyWrites(int fd, std::deque<ZeroCopyWrite>* writes);
+
   utils::Error ConvertBoostError(const boost::system::error_code&) const;
 
   boost::asio::ip::tcp::socket socket_;
   std::unique_ptr<TcpConnector> connector_;
   std::shared_ptr<utils::Session> session_;
   std::shared_ptr<utils::Endpoint> connect_to_;
-  std::unique_ptr<std::vector<boost::asio::const_buffer>> write_buffer_;
-  std::unique_ptr<std::vector<boost::asio::mutable_buffer>> read_buffer_;
-  utils::Cancelable read_cancelable_, write_cancelable_, report_cancelable_,
-      connect_cancelable_;
+  std::shared_ptr<const SocketOptions> socket_options_;
+  utils::BufferReserveSize read_reserve_size_{0, 0};
+  size_t read_size_{NEKIT_TCP_SOCKET_READ_SIZE};
+  bool speculate_read_{true};
+
+  std::deque<PendingWrite> write_queue_;
+  // The data of the queued writes not handed to the system yet.
+  utils::Buffer write_buffer_;
+  size_t writing_bytes_{0};
+  bool flushing_{false}, flush_scheduled_{false}, cork_{false};
+  EventHandler close_write_handler_;
+
+  FastOpenState fast_open_state_{FastOpenState::None};
+
+  ZeroCopyState zero_copy_state_{ZeroCopyState::Unknown};
+  std::deque<ZeroCopyWrite> zero_copy_writes_;
+  uint32_t zero_copy_next_id_{0};
+  // Set when the system has too many notifications outstanding, zero copy is
+  // resumed once the outstanding writes complete.
+  bool zero_copy_suspended_{false}, zero_copy_waiting_{false};
+
+  // `write_cancelable_` guards the whole write queue.
+  utils::Cancelable read_cancelable_, write_cancelable_, close_cancelable_,
+      report_cancelable_, connect_cancelable_, zero_copy_cancelable_;
 
   data_flow::FlowStateMachine state_machine_;
 };
@@ -22,47 +22,89 @@
 
 #pragma once
 
+#include <deque>
+#include <functional>
 #include <memory>
-#include <unordered_map>
 
+#include <boost/intrusive/list.hpp>
 #include <boost/noncopyable.hpp>
 
+#include "../config.h"
 #include "../data_flow/local_data_flow_interface.h"
 #include "../data_flow/remote_data_flow_interface.h"
 #include "../rule/rule_manager.h"
 #include "../utils/async_interface.h"
 #include "../utils/cancelable.h"
+#include "../utils/memory_budget.h"
+#include "../utils/pool_allocator.h"
 #include "../utils/session.h"
 #include "../utils/timer.h"
 #include "../utils/trackable.h"
+#include "splice_relay.h"
 
 namespace nekit {
 namespace transport {
 
 class TunnelManager;
 
+// Tunnels are allocated from the pool of the runloop and linked into the list
+// of their manager.
 class Tunnel final : public utils::AsyncInterface,
                      public utils::Trackable,
+                     public utils::PoolAllocated,
+                     public boost::intrusive::list_base_hook<>,
                      private boost::noncopyable {
  public:
   Tunnel(std::unique_ptr<data_flow::LocalDataFlowInterface>&& local_data_flow,
-         rule::RuleManager* rule_manager);
+         rule::RuleManager* rule_manager,
+         size_t memory_limit = NEKIT_TUNNEL_MEMORY_LIMIT,
+         utils::MemoryBudget* parent_memory_budget = nullptr);
   ~Tunnel();
 
   void Open();
 
+  // The buffer memory held by the tunnel. Reading from either side is paused
+  // when it is exhausted.
+  const utils::MemoryBudget& memory_budget() const;
+
+  // Stop reading from one side when the data not written to the other side
+  // reaches `high` bytes, until it drops to `low` bytes. Must be called
+  // before `Open`.
+  void SetForwardWatermarks(size_t high, size_t low);
+
   utils::Runloop* GetRunloop() override;
 
   friend class TunnelManager;
 
  private:
+  // The data forwarded from one side to the other.
+  struct Forwarding {
+    data_flow::DataFlowInterface* from{nullptr};
+    data_flow::DataFlowInterface* to{nullptr};
+
+    // A read is in progress or waiting for memory.
+    bool pending{false};
+    // Stopped reading at the high watermark until the low watermark.
+    bool paused{false};
+    // `from` is closed, `to` is closed once the data in flight is written.
+    bool eof{false};
+
+    size_t bytes_in_flight{0};
+    // The memory of each write in flight, the writes complete in order.
+    std::deque<utils::MemoryBudget::Reservation> reservations;
+
+    utils::Cancelable read_cancelable, write_cancelable;
+  };
+
   void MatchRule();
   void ConnectToRemote();
   void FinishLocalNegotiation();
   void BeginForward();
+  // Relay the data in the kernel if both sides are plain TCP sockets now.
+  bool BeginSplice();
 
-  void ForwardLocal();
-  void ForwardRemote();
+  void Forward(Forwarding* forwarding);
+  void CloseWriteIfDrained(Forwarding* forwarding);
 
   void CheckTunnelStatus();
   void ReleaseTunnel();
@@ -71,6 +113,9 @@ class Tunnel final : public utils::AsyncInterface,
 
   void ResetTimer();
 
+  // Call `handler` once the memory budget is available again.
+  void WaitForMemory(std::function<void()> handler);
+
   std::shared_ptr<utils::Session> session_;
 
   rule::RuleManager* rule_manager_;
@@ -78,28 +123,56 @@ class Tunnel final : public utils::AsyncInterface,
 
   std::unique_ptr<data_flow::LocalDataFlowInterface> local_data_flow_;
   std::unique_ptr<data_flow::RemoteDataFlowInterface> remote_data_flow_;
+  std::unique_ptr<SpliceRelay> splice_relay_;
+
+  // The reservations must be released before the budget is destroyed.
+  utils::MemoryBudget memory_budget_;
+  Forwarding local_forwarding_, remote_forwarding_;
 
-  utils::Cancelable open_cancelable_, local_read_cancelable_,
-      local_write_cancelable_, remote_read_cancelable_,
-      remote_write_cancelable_, rule_cancelable_;
+  size_t high_watermark_{NEKIT_TUNNEL_FORWARD_HIGH_WATERMARK};
+  size_t low_watermark_{NEKIT_TUNNEL_FORWARD_LOW_WATERMARK};
 
-  utils::Timer timeout_timer_;
+  // `forward_cancelable_` guards all the writes in flight.
+  utils::Cancelable open_cancelable_, rule_cancelable_, memory_cancelable_,
+      forward_cancelable_;
+
+  utils::WheelTimer timeout_timer_;
 };
 
 class TunnelManager final : private boost::noncopyable {
  public:
+  ~TunnelManager();
+
   Tunnel& Build(
       std::unique_ptr<data_flow::LocalDataFlowInterface>&& local_data_flow,
       rule::RuleManager* rule_manager);
 
   void CloseAll();
 
+  // All the tunnels are charged to `memory_budget` as well.
+  void SetMemoryBudget(utils::MemoryBudget* memory_budget);
+  void SetTunnelMemoryLimit(size_t limit);
+  void SetForwardWatermarks(size_t high, size_t low);
+
+  size_t tunnel_count() const;
+
+  // Call `handler` once when there is no tunnel, immediately if there is
+  // none now.
+  void NotifyWhenEmpty(std::function<void()> handler);
+
   friend class Tunnel;
 
  private:
   void NotifyClosed(Tunnel* tunnel);
 
-  std::unordered_map<void*, std::unique_ptr<transport::Tunnel>> tunnels_;
+  utils::MemoryBudget* memory_budget_{nullptr};
+  size_t tunnel_memory_limit_{NEKIT_TUNNEL_MEMORY_LIMIT};
+  size_t high_watermark_{NEKIT_TUNNEL_FORWARD_HIGH_WATERMARK};
+  size_t low_watermark_{NEKIT_TUNNEL_FORWARD_LOW_WATERMARK};
+
+  std::function<void()> empty_handler_;
+
+  boost::intrusive::list<Tunnel> tunnels_;
 };
 }  // namespace transport
 }  // namespace nekit
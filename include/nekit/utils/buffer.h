@@ -25,21 +25,170 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <iterator>
 #include <memory>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
+#include <boost/assert.hpp>
 #include <boost/noncopyable.hpp>
 
+#include "../config.h"
+#include "buffer_pool.h"
+#include "buffer_reserve_size.h"
+
 namespace nekit {
 namespace utils {
 
-struct Buf;
+// Buf can't have size 0
+//
+// A chunk can be viewed by several `Buf`s. Each `Buf` owns the window
+// [begin_, begin_ + capacity_) of the chunk. Windows created by `Break` are
+// disjoint so they can be written freely, while `Share` creates windows that
+// overlap, those `Buf`s are marked as `shared_` and copy the data before it
+// is modified.
+struct Buf final {
+  BufferChunk* chunk_;
+
+  size_t begin_;
+  size_t capacity_;
+  size_t offset_;
+  size_t size_;
+
+  bool shared_;
+
+  std::unique_ptr<Buf> next_buf_;
+  Buf* prev_buf_;
+
+  Buf(size_t size);
+  // Create a view of `size` bytes of `chunk` starting at `begin`.
+  Buf(BufferChunk* chunk, size_t begin, size_t size, bool shared);
+  ~Buf();
+
+  // The nodes are small and allocated as frequently as the chunks, so they
+  // are recycled by the pool as well.
+  static void* operator new(size_t size);
+  static void operator delete(void* pointer);
+
+  uint8_t* data() const { return chunk_->data() + begin_; }
+
+  // Must be called before modifying the data.
+  void MakeWritable() {
+    if (shared_) {
+      CopyOnWrite();
+    }
+  }
+
+  void SetNext(std::unique_ptr<Buf> buf) {
+    next_buf_ = std::move(buf);
+    if (next_buf_) {
+      next_buf_->prev_buf_ = this;
+    }
+  }
+
+  // Split the window at `pos`, the data after `pos` is moved to a new `Buf`
+  // viewing the same chunk, no data is copied. The returned `Buf` is detached
+  // from this one.
+  std::unique_ptr<Buf> Break(size_t pos);
+
+ private:
+  void CopyOnWrite();
+};
+
+// A position in a `Buffer` that remembers the chunk it is in, so sequential
+// accesses don't search the chunks from the head.
+//
+// A cursor is invalidated when the layout of the buffer changes, i.e., by
+// anything other than reading or writing the data.
+template <typename T>
+class BufferCursor {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = uint8_t;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+
+  BufferCursor() = default;
+  BufferCursor(Buf* buf, size_t offset, size_t position)
+      : buf_{buf}, offset_{offset}, position_{position} {}
+
+  size_t position() const { return position_; }
+
+  bool AtEnd() const { return !buf_; }
+
+  reference operator*() const {
+    return Data(buf_, std::is_const<T>{})[offset_];
+  }
+
+  // The data that can be accessed from the cursor without crossing a chunk.
+  pointer data() const { return Data(buf_, std::is_const<T>{}) + offset_; }
+  size_t contiguous_size() const { return buf_ ? buf_->size_ - offset_ : 0; }
+
+  BufferCursor& operator++() {
+    position_++;
+    if (++offset_ == buf_->size_) {
+      buf_ = buf_->next_buf_.get();
+      offset_ = 0;
+    }
+    return *this;
+  }
+
+  BufferCursor operator++(int) {
+    auto cursor = *this;
+    ++*this;
+    return cursor;
+  }
+
+  BufferCursor& operator+=(size_t len) {
+    position_ += len;
+    len += offset_;
+    while (buf_ && len >= buf_->size_) {
+      len -= buf_->size_;
+      buf_ = buf_->next_buf_.get();
+    }
+    offset_ = len;
+    return *this;
+  }
+
+  // Only cursors of the same buffer can be compared.
+  bool operator==(const BufferCursor& cursor) const {
+    return position_ == cursor.position_;
+  }
+
+  bool operator!=(const BufferCursor& cursor) const {
+    return position_ != cursor.position_;
+  }
+
+ private:
+  static uint8_t* Data(Buf* buf, std::false_type) {
+    buf->MakeWritable();
+    return buf->data() + buf->offset_;
+  }
+
+  static const uint8_t* Data(Buf* buf, std::true_type) {
+    return buf->data() + buf->offset_;
+  }
+
+  Buf* buf_{nullptr};
+  size_t offset_{0};
+  size_t position_{0};
+};
 
 // The buffer can be empty, which has size 0.
 class Buffer final : private boost::noncopyable {
  public:
+  using Cursor = BufferCursor<uint8_t>;
+  using ConstCursor = BufferCursor<const uint8_t>;
+
   Buffer();
+  // The data is not initialized, the chunks are recycled by the pool and may
+  // hold anything.
   Buffer(size_t size);
+  // Allocate the buffer with space reserved before and after the data, so it
+  // can grow in both directions without allocating.
+  Buffer(size_t size, const BufferReserveSize& reserve_size);
   Buffer(Buffer&& buffer);
   Buffer& operator=(Buffer&& buffer);
   ~Buffer();
@@ -49,6 +198,10 @@ class Buffer final : private boost::noncopyable {
   uint8_t& operator[](size_t index);
   const uint8_t& operator[](size_t index) const;
 
+  // `pos` can be `size()`, which returns the end cursor.
+  Cursor CursorAt(size_t pos);
+  ConstCursor CursorAt(size_t pos) const;
+
   void Insert(Buffer&& buffer, size_t pos);
   void Insert(size_t skip, size_t len);
 
@@ -68,8 +221,59 @@ class Buffer final : private boost::noncopyable {
   void SetData(size_t skip, size_t len, const void* source);
   void SetData(size_t skip, size_t len, const Buffer& source, size_t offset);
 
+  // Split the buffer at `skip`, the data after `skip` is returned as a new
+  // buffer. The underlying memory is shared instead of copied.
   Buffer Break(size_t skip);
 
+  // Return a buffer viewing the data in [skip, skip + len) without copying.
+  // The memory is copied lazily when either buffer modifies it.
+  Buffer Share(size_t skip, size_t len) const;
+
+  // Call `walker(data, len)` with each chunk of data starting from `from`
+  // until it returns `false`. The chunks shared with other buffers are copied
+  // first so they can be modified, walk a const buffer to only read them.
+  template <typename Walker>
+  void ForEachChunk(Walker&& walker, size_t from = 0) {
+    BOOST_ASSERT(from <= size());
+
+    if (from == size()) {
+      return;
+    }
+
+    auto location = Locate(from);
+    size_t skip = location.second;
+    for (Buf* current = location.first; current;
+         current = current->next_buf_.get()) {
+      current->MakeWritable();
+      if (!walker(current->data() + current->offset_ + skip,
+                  current->size_ - skip)) {
+        return;
+      }
+      skip = 0;
+    }
+  }
+
+  template <typename Walker>
+  void ForEachChunk(Walker&& walker, size_t from = 0) const {
+    BOOST_ASSERT(from <= size());
+
+    if (from == size()) {
+      return;
+    }
+
+    auto location = Locate(from);
+    size_t skip = location.second;
+    for (const Buf* current = location.first; current;
+         current = current->next_buf_.get()) {
+      if (!walker(static_cast<const uint8_t*>(current->data()) +
+                      current->offset_ + skip,
+                  current->size_ - skip)) {
+        return;
+      }
+      skip = 0;
+    }
+  }
+
   void WalkInternalChunk(
       const std::function<bool(void* data, size_t len, void* context)>& walker,
       size_t from, void* context);
@@ -79,15 +283,64 @@ class Buffer final : private boost::noncopyable {
 
   size_t FindLocation(const void* pointer);
 
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  // Find the first occurrence of `pattern` starting from `from`, the
+  // occurrence can span several chunks. Return `npos` if not found.
+  size_t Find(const void* pattern, size_t len, size_t from = 0) const;
+
   size_t size() const;
 
+  // The memory allocated for the chunks only this buffer views, each chunk
+  // counted once with its reserved and unused space. The chunks shared with
+  // other buffers are not counted, so the same memory is never counted twice.
+  size_t memory_size() const;
+
+  // The number of chunks the data is stored in, a buffer with a lot of small
+  // chunks is slow to walk and to send.
+  size_t chunk_count() const;
+
+  // Coalesce adjacent small chunks once the buffer has more than
+  // `max_chunk_count` chunks. It is disabled by default since it copies the
+  // data, enable it for buffers that accumulate a lot of small pieces.
+  //
+  // The setting belongs to this buffer object, it is not moved with the data.
+  void EnableCompaction(
+      size_t max_chunk_count = NEKIT_BUFFER_COMPACTION_CHUNK_COUNT);
+  void DisableCompaction();
+
+  // Coalesce adjacent small chunks now.
+  void Compact();
+
+  friend class ConstBufferSequence;
+  friend class MutableBufferSequence;
+
  private:
+  // Find the `Buf` containing `pos` and the offset of `pos` in it.
+  std::pair<Buf*, size_t> Locate(size_t pos) const;
+  void BuildIndex() const;
+  // Must be called whenever the layout of the chunks changes.
+  void DropCache() const;
+  void Clear();
+  void MaybeCompact();
+
   void InsertBufAt(Buf* buf, Buffer&& buffer, size_t pos);
-  void ResetTail();
 
   std::unique_ptr<Buf> head_;
   Buf* tail_;
   size_t size_;
+  size_t chunk_count_;
+
+  // 0 if compaction is disabled.
+  size_t compaction_threshold_{0};
+  size_t compaction_trigger_{0};
+
+  // The last located `Buf` and its position, so sequential accesses resume
+  // from where the last one stops.
+  mutable Buf* hint_buf_{nullptr};
+  mutable size_t hint_pos_{0};
+  // The positions of all the `Buf`s, built only for buffers with many chunks.
+  mutable std::vector<std::pair<size_t, Buf*>> index_;
 };
 }  // namespace utils
 }  // namespace nekit
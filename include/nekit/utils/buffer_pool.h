@@ -0,0 +1,106 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/noncopyable.hpp>
+
+namespace nekit {
+namespace utils {
+
+struct BufferPoolArena;
+
+// The header placed in front of every chunk of memory backing a `Buffer`.
+struct alignas(16) BufferChunk {
+  // `nullptr` if the chunk is allocated from heap directly.
+  BufferPoolArena* arena_;
+  std::size_t capacity_;
+  std::uint32_t size_class_;
+  // Number of `Buf`s viewing the chunk, maintained by `Buffer`.
+  std::uint32_t refcount_;
+
+  std::uint8_t* data() { return reinterpret_cast<std::uint8_t*>(this + 1); }
+
+  static BufferChunk* FromData(void* data) {
+    return reinterpret_cast<BufferChunk*>(data) - 1;
+  }
+};
+
+/**
+ * @brief A size-classed chunk allocator backing `Buffer`.
+ *
+ * Chunks are carved from large slabs and recycled through per size class free
+ * lists instead of being returned to the system.
+ *
+ * @note The pool is not thread safe. Every `Runloop` owns one and installs it
+ * as the current pool of the thread running it, a `Buffer` must be released
+ * on the thread it is allocated. Chunks may outlive the pool, the memory is
+ * reclaimed when the last chunk is returned.
+ */
+class BufferPool final : private boost::noncopyable {
+ public:
+  struct Statistics {
+    // Allocations served from a free list.
+    std::uint64_t hit_count{0};
+    // Allocations that required fresh memory.
+    std::uint64_t miss_count{0};
+    // Memory held by the pool, including chunks in use and cached chunks.
+    std::size_t resident_bytes{0};
+    // Memory of chunks currently in use.
+    std::size_t allocated_bytes{0};
+  };
+
+  // Install a pool as the current pool of the calling thread during the
+  // lifetime of the scope.
+  class Scope final : private boost::noncopyable {
+   public:
+    explicit Scope(BufferPool* pool);
+    ~Scope();
+
+   private:
+    BufferPool* previous_;
+  };
+
+  explicit BufferPool(bool use_huge_page = false);
+  ~BufferPool();
+
+  BufferChunk* Allocate(std::size_t size);
+
+  Statistics GetStatistics() const;
+
+  // Return a chunk to the pool it is allocated from.
+  static void Deallocate(BufferChunk* chunk);
+
+  // Allocate from the current pool of the thread, or from heap if there is
+  // none.
+  static BufferChunk* AllocateFromCurrent(std::size_t size);
+
+  static BufferPool* Current();
+
+ private:
+  BufferPoolArena* arena_;
+};
+}  // namespace utils
+}  // namespace nekit
@@ -0,0 +1,164 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+
+#include <boost/asio/buffer.hpp>
+
+#include "buffer.h"
+
+namespace nekit {
+namespace utils {
+
+// Iterates over the chunks of a `Buffer` as boost.asio buffers.
+template <typename BoostBuffer>
+class BufferSequenceIterator {
+ public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = BoostBuffer;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const BoostBuffer*;
+  using reference = BoostBuffer;
+
+  BufferSequenceIterator() = default;
+  BufferSequenceIterator(Buf* buf, Buf* first, size_t skip, Buf* tail)
+      : buf_{buf}, first_{first}, skip_{skip}, tail_{tail} {}
+
+  BoostBuffer operator*() const {
+    size_t skip = buf_ == first_ ? skip_ : 0;
+    return BoostBuffer(buf_->data() + buf_->offset_ + skip,
+                       buf_->size_ - skip);
+  }
+
+  BufferSequenceIterator& operator++() {
+    buf_ = buf_->next_buf_.get();
+    return *this;
+  }
+
+  BufferSequenceIterator operator++(int) {
+    auto iter = *this;
+    ++*this;
+    return iter;
+  }
+
+  BufferSequenceIterator& operator--() {
+    buf_ = buf_ ? buf_->prev_buf_ : tail_;
+    return *this;
+  }
+
+  BufferSequenceIterator operator--(int) {
+    auto iter = *this;
+    --*this;
+    return iter;
+  }
+
+  bool operator==(const BufferSequenceIterator& iter) const {
+    return buf_ == iter.buf_;
+  }
+
+  bool operator!=(const BufferSequenceIterator& iter) const {
+    return buf_ != iter.buf_;
+  }
+
+ private:
+  Buf* buf_{nullptr};
+  Buf* first_{nullptr};
+  size_t skip_{0};
+  Buf* tail_{nullptr};
+};
+
+// Adapt the data of a `Buffer` starting from `from` to the
+// ConstBufferSequence concept of boost.asio, so it can be passed to asio
+// operations directly without collecting the chunks first.
+//
+// The sequence only refers to the chunks. The buffer can be moved, but its
+// layout must not change while the sequence is in use.
+class ConstBufferSequence {
+ public:
+  using value_type = boost::asio::const_buffer;
+  using const_iterator = BufferSequenceIterator<value_type>;
+
+  explicit ConstBufferSequence(const Buffer& buffer, size_t from = 0)
+      : tail_{buffer.tail_} {
+    BOOST_ASSERT(from <= buffer.size());
+
+    if (from != buffer.size()) {
+      auto location = buffer.Locate(from);
+      first_ = location.first;
+      skip_ = location.second;
+    }
+  }
+
+  const_iterator begin() const {
+    return const_iterator(first_, first_, skip_, tail_);
+  }
+
+  const_iterator end() const {
+    return const_iterator(nullptr, first_, skip_, tail_);
+  }
+
+ private:
+  Buf* first_{nullptr};
+  size_t skip_{0};
+  Buf* tail_;
+};
+
+// The MutableBufferSequence counterpart of `ConstBufferSequence`. The shared
+// chunks are copied when the sequence is created.
+class MutableBufferSequence {
+ public:
+  using value_type = boost::asio::mutable_buffer;
+  using const_iterator = BufferSequenceIterator<value_type>;
+
+  explicit MutableBufferSequence(Buffer& buffer, size_t from = 0)
+      : tail_{buffer.tail_} {
+    BOOST_ASSERT(from <= buffer.size());
+
+    if (from != buffer.size()) {
+      auto location = buffer.Locate(from);
+      first_ = location.first;
+      skip_ = location.second;
+
+      for (Buf* current = first_; current;
+           current = current->next_buf_.get()) {
+        current->MakeWritable();
+      }
+    }
+  }
+
+  const_iterator begin() const {
+    return const_iterator(first_, first_, skip_, tail_);
+  }
+
+  const_iterator end() const {
+    return const_iterator(nullptr, first_, skip_, tail_);
+  }
+
+ private:
+  Buf* first_{nullptr};
+  size_t skip_{0};
+  Buf* tail_;
+};
+}  // namespace utils
+}  // namespace nekit
@@ -22,15 +22,26 @@
 
 #pragma once
 
-#include <memory>
-
-#include <boost/noncopyable.hpp>
+#include <cstddef>
+#include <cstdint>
 
 namespace nekit {
 namespace utils {
+
+/**
+ * @brief A cancellation token shared by all the copies of it.
+ *
+ * The token is taken from a pool of the current thread and reference counted
+ * without atomic operations, so creating, copying and checking a cancelable
+ * never allocates in the steady state.
+ *
+ * @note A cancelable and all its copies must be used on the thread creating
+ * it, i.e., the thread of the runloop it belongs to.
+ */
 class Cancelable {
  public:
   Cancelable();
+  ~Cancelable();
 
   Cancelable(const Cancelable& cancelable);
   Cancelable& operator=(const Cancelable& cancelable);
@@ -47,8 +58,21 @@ class Cancelable {
 
   bool canceled() const;
 
+  // The number of released tokens the calling thread keeps for reuse.
+  static size_t FreeTokenCount();
+
+  // The state shared by the copies, only public to the pool.
+  struct Token {
+    uint32_t references;
+    bool canceled;
+    Token* next;
+  };
+
  private:
-  std::shared_ptr<bool> canceled_;
+  static Token* AcquireToken();
+  static void ReleaseToken(Token* token);
+
+  Token* token_;
 };
 }  // namespace utils
 }  // namespace nekit
@@ -0,0 +1,110 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace nekit {
+namespace utils {
+
+/**
+ * @brief Accounts the buffer memory held by a tunnel, an instance or
+ * anything else.
+ *
+ * A tunnel charges the memory of the chunks of each buffer from the time
+ * it is read until it is written. The buffers kept inside the data flows,
+ * e.g., the write queue of `TcpSocket` and the buffers of TLS and the HTTP
+ * rewriter, are not charged, so `current()` and `peak()` are lower than the
+ * memory actually used.
+ *
+ * The limit is soft, reserving memory always succeeds. Before allocating more
+ * buffers the owner should check `Available()` and `Wait()` until the memory
+ * is released if the budget is exhausted. The memory reserved from a budget
+ * is charged to the parent as well.
+ *
+ * @note The budget is not thread safe, the parent and the children should be
+ * used on the same thread.
+ */
+class MemoryBudget final : private boost::noncopyable {
+ public:
+  using EventHandler = std::function<void()>;
+
+  // The memory charged to a budget during the lifetime of the object.
+  class Reservation final : private boost::noncopyable {
+   public:
+    Reservation() = default;
+    Reservation(MemoryBudget* budget, size_t size);
+    Reservation(Reservation&& reservation);
+    Reservation& operator=(Reservation&& reservation);
+    ~Reservation();
+
+    void Release();
+
+    size_t size() const;
+
+   private:
+    MemoryBudget* budget_{nullptr};
+    size_t size_{0};
+  };
+
+  // `limit` of 0 means unlimited.
+  explicit MemoryBudget(size_t limit = 0, MemoryBudget* parent = nullptr);
+  ~MemoryBudget();
+
+  size_t limit() const;
+  void set_limit(size_t limit);
+
+  // The memory currently reserved.
+  size_t current() const;
+  // The maximum memory ever reserved.
+  size_t peak() const;
+
+  // Whether there is memory left in this budget and all the parents.
+  bool Available() const;
+
+  Reservation Reserve(size_t size);
+
+  // Call `handler` once the exhausted budget in the chain is available again.
+  // The handler is called synchronously when the memory is released, and
+  // immediately if there is memory left now.
+  void Wait(EventHandler handler);
+
+ private:
+  bool Exhausted() const;
+
+  void Charge(size_t size);
+  void Release(size_t size);
+
+  size_t limit_;
+  size_t current_{0};
+  size_t peak_{0};
+
+  MemoryBudget* parent_;
+
+  std::vector<EventHandler> waiters_;
+};
+}  // namespace utils
+}  // namespace nekit
@@ -0,0 +1,81 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+
+#include "buffer_pool.h"
+
+namespace nekit {
+namespace utils {
+
+// Objects allocated with these come from the `BufferPool` of the current
+// thread, i.e., the pool of the runloop running it, instead of the heap. They
+// must be released on the thread they are allocated, like `Buffer`s.
+
+// An allocator for `std::allocate_shared` and the containers.
+template <typename T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  PoolAllocator() = default;
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) {}
+
+  T* allocate(std::size_t n) {
+    return reinterpret_cast<T*>(
+        BufferPool::AllocateFromCurrent(n * sizeof(T))->data());
+  }
+
+  void deallocate(T* p, std::size_t) {
+    BufferPool::Deallocate(BufferChunk::FromData(p));
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+  return false;
+}
+
+// Inherit from it to create the objects with `new` from the pool.
+class PoolAllocated {
+ public:
+  static void* operator new(std::size_t size) {
+    return BufferPool::AllocateFromCurrent(size)->data();
+  }
+
+  static void operator delete(void* p) {
+    if (p) {
+      BufferPool::Deallocate(BufferChunk::FromData(p));
+    }
+  }
+};
+
+}  // namespace utils
+}  // namespace nekit
@@ -28,20 +28,26 @@
 #include <boost/asio/post.hpp>
 #include <boost/noncopyable.hpp>
 
+#include "../config.h"
 #include "async_task.h"
+#include "buffer_pool.h"
+#include "timer_wheel.h"
 
 namespace nekit {
 namespace utils {
 class Runloop : private boost::noncopyable {
  public:
-  Runloop() = default;
+  Runloop() : buffer_pool_{NEKIT_BUFFER_POOL_USE_HUGE_PAGE != 0} {}
 
   template <typename... Args>
   void Post(Args&&... args) {
     boost::asio::post(io_context_, std::forward<Args>(args)...);
   }
 
-  void Run() { io_context_.run(); }
+  void Run() {
+    BufferPool::Scope scope{&buffer_pool_};
+    io_context_.run();
+  }
 
   void Stop() { io_context_.stop(); }
 
@@ -56,8 +62,22 @@ class Runloop : private boost::noncopyable {
    */
   boost::asio::io_context* BoostIoContext() { return &io_context_; }
 
+  /**
+   * @brief Get the pool backing every `Buffer` allocated on this runloop.
+   */
+  BufferPool* GetBufferPool() { return &buffer_pool_; }
+
+  /**
+   * @brief Get the timer wheel for the coarse timeouts on this runloop.
+   */
+  TimerWheel* GetTimerWheel() { return &timer_wheel_; }
+
  private:
+  // Pending handlers may hold buffers, so the pool must outlive the
+  // `io_context`.
+  BufferPool buffer_pool_;
   boost::asio::io_context io_context_;
+  TimerWheel timer_wheel_{&io_context_};
 };
 
 template <>
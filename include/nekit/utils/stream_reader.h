@@ -22,7 +22,8 @@
 
 #pragma once
 
-#include <boost/algorithm/searching/knuth_morris_pratt.hpp>
+#include <string>
+
 #include <boost/noncopyable.hpp>
 
 #include "../data_flow/data_flow_interface.h"
@@ -59,10 +60,7 @@ class StreamReader : public AsyncInterface, private boost::noncopyable {
   size_t length_to_read_;
 
   size_t last_pos_;
-  size_t pattern_size_;
-  std::unique_ptr<
-      boost::algorithm::knuth_morris_pratt<std::string::const_iterator>>
-      pattern_matcher_;
+  std::string pattern_;
 };
 }  // namespace utils
 }  // namespace nekit
@@ -22,7 +22,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include <boost/asio.hpp>
 #include <boost/thread/thread.hpp>
@@ -44,6 +47,18 @@ class SystemResolver : public ResolverInterface {
   Runloop* GetRunloop() override;
 
  private:
+  // The handler and the cancelable stay on the thread of `runloop_`, the
+  // resolving threads only see the id of the request.
+  struct Request {
+    EventHandler handler;
+    Cancelable cancelable;
+  };
+
+  void FinishRequest(
+      uint64_t id,
+      utils::Result<std::shared_ptr<std::vector<boost::asio::ip::address>>>&&
+          result);
+
   std::error_code ConvertBoostError(const boost::system::error_code& ec);
 
   utils::Runloop* runloop_;
@@ -55,7 +70,12 @@ class SystemResolver : public ResolverInterface {
       work_guard_;
   utils::Runloop resolve_runloop_;
 
-  Cancelable lifetime_;
+  std::unordered_map<uint64_t, Request> requests_;
+  uint64_t next_request_id_{0};
+
+  // Released when the resolver is released, the results posted back after
+  // that are dropped.
+  std::shared_ptr<bool> lifetime_{std::make_shared<bool>(true)};
 };
 }  // namespace utils
 }  // namespace nekit
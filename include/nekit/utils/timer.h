@@ -29,6 +29,7 @@
 
 #include "async_interface.h"
 #include "cancelable.h"
+#include "timer_wheel.h"
 
 namespace nekit {
 namespace utils {
@@ -50,5 +51,28 @@ class Timer : public AsyncInterface, private boost::noncopyable {
 
   Cancelable cancelable_;
 };
+
+// Works the same as `Timer` but on the timer wheel of the runloop, which makes
+// waiting again as cheap as updating a timestamp. The wait is rounded up to
+// the tick of the wheel, so it suits timeouts rather than precise delays.
+class WheelTimer final : public AsyncInterface,
+                         private TimerWheel::Entry,
+                         private boost::noncopyable {
+ public:
+  WheelTimer(utils::Runloop* runloop, std::function<void()> handler);
+
+  ~WheelTimer();
+
+  void Wait(uint32_t milliseconds);
+  void Cancel();
+
+  utils::Runloop* GetRunloop() override;
+
+ private:
+  void OnExpire() override;
+
+  utils::Runloop* runloop_;
+  std::function<void()> handler_;
+};
 }  // namespace utils
 }  // namespace nekit
@@ -0,0 +1,118 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "../config.h"
+
+namespace nekit {
+namespace utils {
+
+/**
+ * @brief A hashed timer wheel for timeouts that are reset much more often
+ * than they fire, such as idle timeouts.
+ *
+ * The timeline is divided into ticks of `NEKIT_TIMER_WHEEL_TICK`
+ * milliseconds, and an armed entry is linked to the slot of the tick it
+ * expires at. Pushing the deadline of an armed entry later only updates the
+ * deadline, the entry is moved to the right slot when its old slot is
+ * visited. Deadlines further than one revolution of the wheel are handled the
+ * same way, so arming and disarming are always O(1) and never allocate.
+ *
+ * The wheel only wakes up for the next slot holding entries and stops when
+ * there is none.
+ *
+ * @note Entries fire up to one tick late. The wheel is not thread safe.
+ */
+class TimerWheel final : private boost::noncopyable {
+ public:
+  class Entry;
+
+  explicit TimerWheel(boost::asio::io_context* io_context);
+  ~TimerWheel();
+
+  // Call `OnExpire()` of `entry` after `milliseconds`. Arming an armed entry
+  // again only moves its deadline.
+  void Arm(Entry* entry, uint32_t milliseconds);
+  void Disarm(Entry* entry);
+
+  // The number of armed entries.
+  size_t size() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Link {
+    Link* prev;
+    Link* next;
+  };
+
+  uint64_t Now() const;
+
+  void Insert(Entry* entry, uint64_t tick);
+  static void Remove(Link* link);
+
+  void Schedule(uint64_t tick);
+  void Advance();
+  void ScheduleNext();
+
+  std::unique_ptr<Link[]> slots_;
+  Clock::time_point epoch_;
+  // Every slot up to this tick has been visited.
+  uint64_t current_tick_{0};
+  uint64_t scheduled_tick_{0};
+  bool scheduled_{false};
+  size_t size_{0};
+
+  boost::asio::steady_timer timer_;
+};
+
+class TimerWheel::Entry : private TimerWheel::Link {
+ public:
+  Entry();
+  virtual ~Entry();
+
+  bool armed() const;
+
+ protected:
+  virtual void OnExpire() = 0;
+
+ private:
+  friend class TimerWheel;
+
+  TimerWheel* wheel_{nullptr};
+  uint64_t deadline_{0};
+  // The tick of the slot the entry is linked to, it may be earlier than the
+  // deadline.
+  uint64_t slot_tick_{0};
+};
+}  // namespace utils
+}  // namespace nekit
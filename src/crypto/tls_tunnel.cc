@@ -129,10 +129,9 @@ utils::Buffer TlsTunnel::ReadCipherTextData() {
 void TlsTunnel::WriteCipherTextData(utils::Buffer&& buffer) {
   size_t buffer_processed = 0;
   while (buffer_processed != buffer.size() && !error_) {
-    buffer.WalkInternalChunk(
-        [this, &buffer_processed](const void* data, size_t len, void* context) {
-          (void)context;
-
+    // Walk the const buffer so the shared chunks are not copied.
+    static_cast<const utils::Buffer&>(buffer).ForEachChunk(
+        [this, &buffer_processed](const void* data, size_t len) {
           need_cipher_input_ = false;
           int n = BIO_write(cipher_bio_.get(), data, len);
 
@@ -151,7 +150,7 @@ void TlsTunnel::WriteCipherTextData(utils::Buffer&& buffer) {
             return false;
           }
         },
-        buffer_processed, nullptr);
+        buffer_processed);
 
     if (!error_) {
       FlushBuffer();
@@ -192,10 +191,8 @@ utils::Result<TlsTunnel::HandShakeAction> TlsTunnel::HandShake() {
 void TlsTunnel::InternalPlainWrite() {
   size_t writed = 0;
 
-  pending_write_plain_.WalkInternalChunk(
-      [this, &writed](const void* data, size_t data_len, void* context) {
-        (void)context;
-
+  static_cast<const utils::Buffer&>(pending_write_plain_).ForEachChunk(
+      [this, &writed](const void* data, size_t data_len) {
         int n = SSL_write(ssl_.get(), data, data_len);
         if ((size_t)n == data_len) {
           writed += n;
@@ -220,8 +217,7 @@ void TlsTunnel::InternalPlainWrite() {
             error_ = TlsTunnelErrorCategory::FromSslError(ERR_get_error());
             return false;
         }
-      },
-      0, nullptr);
+      });
 
   pending_write_plain_.ShrinkFront(writed);
 
@@ -237,10 +233,8 @@ void TlsTunnel::FlushPlainBuffer() {
   bool stop = false;
   do {
     pending_read_plain_.InsertBack(NEKIT_TLS_READ_SIZE);
-    pending_read_plain_.WalkInternalChunk(
-        [this, &offset, &stop](void* data, size_t len, void* context) {
-          (void)context;
-
+    pending_read_plain_.ForEachChunk(
+        [this, &offset, &stop](void* data, size_t len) {
           int l = SSL_read(ssl_.get(), data, len);
           if (l <= 0) {
             stop = true;
@@ -266,7 +260,7 @@ void TlsTunnel::FlushPlainBuffer() {
             HEDLEY_UNREACHABLE_RETURN(false);
           }
         },
-        offset, nullptr);
+        offset);
   } while (!stop);
 
   pending_read_plain_.ShrinkBack(pending_read_plain_.size() - offset);
@@ -284,15 +278,13 @@ void TlsTunnel::FlushCipherBuffer() {
       pending_read_cipher_.InsertBack(pending);
     }
 
-    pending_read_cipher_.WalkInternalChunk(
-        [this](void* data, size_t len, void* context) {
-          (void)context;
-
+    pending_read_cipher_.ForEachChunk(
+        [this](void* data, size_t len) {
           // This conversion makes sense since len can't be ULONG_MAX
           BOOST_VERIFY((size_t)BIO_read(cipher_bio_.get(), data, len) == len);
           return true;
         },
-        offset, nullptr);
+        offset);
   }
 }
 
@@ -119,6 +119,10 @@ const FlowStateMachine& HttpDataFlow::StateMachine() const {
 
 DataFlowInterface* HttpDataFlow::NextHop() const { return data_flow_.get(); }
 
+bool HttpDataFlow::IsPassThrough() const {
+  return state_machine_.State() == FlowState::Established && !pending_payload_;
+}
+
 DataType HttpDataFlow::FlowDataType() const { return DataType::Stream; }
 
 std::shared_ptr<utils::Session> HttpDataFlow::Session() const {
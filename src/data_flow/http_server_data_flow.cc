@@ -87,6 +87,9 @@ HttpServerDataFlow::HttpServerDataFlow(
                 std::make_shared<HttpServerHeaderRewriterDelegate>(this)} {
   BOOST_ASSERT_MSG(data_flow_->FlowDataType() == DataType::Stream,
                    "Packet type is not supported yet.");
+
+  // The header may arrive in a lot of small pieces.
+  first_header_.EnableCompaction();
 }
 
 HttpServerDataFlow::~HttpServerDataFlow() {
@@ -193,6 +196,11 @@ data_flow::DataFlowInterface* HttpServerDataFlow::NextHop() const {
   return data_flow_.get();
 }
 
+bool HttpServerDataFlow::IsPassThrough() const {
+  // The requests of a non-CONNECT session are rewritten.
+  return is_connect_ && state_machine_.State() == FlowState::Established;
+}
+
 data_flow::DataType HttpServerDataFlow::FlowDataType() const {
   return DataType::Stream;
 }
@@ -60,6 +60,10 @@ const FlowStateMachine& Socks5DataFlow::StateMachine() const {
 
 DataFlowInterface* Socks5DataFlow::NextHop() const { return data_flow_.get(); }
 
+bool Socks5DataFlow::IsPassThrough() const {
+  return state_machine_.State() == FlowState::Established;
+}
+
 DataType Socks5DataFlow::FlowDataType() const { return DataType::Stream; }
 
 std::shared_ptr<utils::Session> Socks5DataFlow::Session() const {
@@ -267,6 +271,7 @@ void Socks5DataFlow::DoNegotiation(EventHandler handler) {
                                       return;
                                     }
 
+                                    state_machine_.Connected();
                                     handler({});
                                     return;
                                   });
@@ -123,6 +123,10 @@ DataFlowInterface* Socks5ServerDataFlow::NextHop() const {
   return data_flow_.get();
 }
 
+bool Socks5ServerDataFlow::IsPassThrough() const {
+  return state_machine_.State() == FlowState::Established;
+}
+
 DataType Socks5ServerDataFlow::FlowDataType() const { return DataType::Stream; }
 
 std::shared_ptr<utils::Session> Socks5ServerDataFlow::Session() const {
@@ -186,8 +190,10 @@ utils::Cancelable Socks5ServerDataFlow::Continue(EventHandler handler) {
   buffer[2] = 0;
   buffer[3] = type;
 
-  for (size_t i = 4; i < len - 4; i++) {
-    buffer[i] = 0;
+  // The chunk is not zeroed, clear the whole bound address and port so no
+  // leftover data is sent.
+  for (auto cursor = buffer.CursorAt(4); !cursor.AtEnd(); ++cursor) {
+    *cursor = 0;
   }
 
   open_cancelable_ = data_flow_->Write(
@@ -226,14 +232,11 @@ void Socks5ServerDataFlow::AppendToAuthBuffer(const utils::Buffer& buffer) {
   BOOST_ASSERT(pending_auth_length_ + buffer.size() <=
                NEKIT_SOCKS5_SERVER_BUFFER_SIZE);
 
-  buffer.WalkInternalChunk(
-      [this](const void* data, size_t len, void* context) {
-        (void)context;
-        std::memcpy(pending_auth_.get() + pending_auth_length_, data, len);
-        pending_auth_length_ += len;
-        return true;
-      },
-      0, nullptr);
+  buffer.ForEachChunk([this](const void* data, size_t len) {
+    std::memcpy(pending_auth_.get() + pending_auth_length_, data, len);
+    pending_auth_length_ += len;
+    return true;
+  });
 }
 
 void Socks5ServerDataFlow::NegotiateRead() {
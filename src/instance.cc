@@ -21,6 +21,14 @@
 
 #include "nekit/instance.h"
 
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <boost/assert.hpp>
 
 #include "nekit/utils/error.h"
@@ -32,38 +40,207 @@
 
 namespace nekit {
 
-Instance::Instance(std::string name) : name_{name} {}
+namespace {
+void PinCurrentThread(size_t index) {
+#if defined(__linux__)
+  unsigned int cpu_count = std::thread::hardware_concurrency();
+  if (!cpu_count) {
+    return;
+  }
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(index % cpu_count, &cpu_set);
+  int error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  if (error) {
+    NEWARN << "Failed to pin worker " << index << " to CPU "
+           << index % cpu_count << " due to "
+           << std::error_code(error, std::generic_category()).message()
+           << ".";
+    return;
+  }
+
+  NEDEBUG << "Pinned worker " << index << " to CPU " << index % cpu_count
+          << ".";
+#else
+  (void)index;
+  NEDEBUG << "Pinning workers is not supported.";
+#endif
+}
+}  // namespace
+
+Instance::Instance(std::string name, size_t worker_count) : name_{name} {
+  BOOST_ASSERT(worker_count > 0);
+
+  for (size_t i = 0; i < worker_count; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+
+  SetMemoryLimit(NEKIT_INSTANCE_MEMORY_LIMIT);
+}
+
+size_t Instance::worker_count() const { return workers_.size(); }
+
+utils::Runloop *Instance::GetWorkerRunloop(size_t index) {
+  BOOST_ASSERT(index < workers_.size());
+
+  return &workers_[index]->runloop;
+}
 
 void Instance::AddProxyManager(std::unique_ptr<ProxyManager> &&proxy_manager) {
-  BOOST_ASSERT(proxy_manager->GetRunloop() == GetRunloop());
+  for (auto &worker : workers_) {
+    if (proxy_manager->GetRunloop() == &worker->runloop) {
+      proxy_manager->SetMemoryBudget(&worker->memory_budget);
+      worker->proxy_managers.emplace_back(std::move(proxy_manager));
+      return;
+    }
+  }
+
+  BOOST_ASSERT_MSG(false, "The proxy manager does not run on any worker.");
+}
+
+void Instance::AddProxyManagers(ProxyManagerFactory factory) {
+  for (size_t i = 0; i < workers_.size(); i++) {
+    Worker *worker = workers_[i].get();
+    auto proxy_manager = factory(&worker->runloop, i);
+    BOOST_ASSERT(proxy_manager->GetRunloop() == &worker->runloop);
 
-  proxy_managers_.emplace_back(std::move(proxy_manager));
+    proxy_manager->SetMemoryBudget(&worker->memory_budget);
+    worker->proxy_managers.emplace_back(std::move(proxy_manager));
+  }
 }
 
 void Instance::Run() {
   BOOST_ASSERT(ready_);
 
-  BOOST_LOG_SCOPED_THREAD_ATTR(
-      "Instance", boost::log::attributes::constant<std::string>(name_));
+  // The proxy managers must run on their own threads, like `Stop()`.
+  for (auto &worker : workers_) {
+    Worker *worker_ptr = worker.get();
+    worker->runloop.Post([worker_ptr]() {
+      for (auto &manager : worker_ptr->proxy_managers) {
+        manager->Run();
+      }
+    });
+  }
 
-  for (auto &manager : proxy_managers_) {
-    manager->Run();
+  NEINFO << "Start running instance with " << workers_.size() << " workers.";
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < workers_.size(); i++) {
+    threads.emplace_back([this, i]() { RunWorker(i); });
   }
 
-  NEINFO << "Start running instance.";
-  runloop_.Run();
+  RunWorker(0);
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
 
   NEINFO << "Instance stopped.";
 }
 
+void Instance::RunWorker(size_t index) {
+  BOOST_LOG_SCOPED_THREAD_ATTR(
+      "Instance", boost::log::attributes::constant<std::string>(name_));
+
+  if (pin_workers_) {
+    PinCurrentThread(index);
+  }
+
+  workers_[index]->runloop.Run();
+}
+
 void Instance::Stop() {
-  runloop_.Stop();
-  for (auto &manager : proxy_managers_) {
-    manager->Stop();
+  // The proxy managers must be stopped on their own threads.
+  for (auto &worker : workers_) {
+    Worker *worker_ptr = worker.get();
+    worker->runloop.Post([worker_ptr]() {
+      for (auto &manager : worker_ptr->proxy_managers) {
+        manager->Stop();
+      }
+      worker_ptr->runloop.Stop();
+    });
   }
   ready_ = false;
 }
 
-utils::Runloop *Instance::GetRunloop() { return &runloop_; }
+void Instance::Drain(uint32_t timeout) {
+  for (auto &worker : workers_) {
+    Worker *worker_ptr = worker.get();
+    worker->runloop.Post([worker_ptr, timeout]() {
+      auto stop = [worker_ptr]() {
+        for (auto &manager : worker_ptr->proxy_managers) {
+          manager->Stop();
+        }
+        worker_ptr->runloop.Stop();
+      };
+
+      if (worker_ptr->proxy_managers.empty()) {
+        stop();
+        return;
+      }
+
+      auto pending =
+          std::make_shared<size_t>(worker_ptr->proxy_managers.size());
+      for (auto &manager : worker_ptr->proxy_managers) {
+        manager->Drain(timeout, [pending, stop]() {
+          if (--*pending == 0) {
+            stop();
+          }
+        });
+      }
+    });
+  }
+  ready_ = false;
+}
+
+void Instance::SetMemoryLimit(size_t limit) {
+  size_t worker_limit = (limit + workers_.size() - 1) / workers_.size();
+  for (auto &worker : workers_) {
+    worker->memory_budget.set_limit(worker_limit);
+  }
+}
+
+const utils::MemoryBudget &Instance::GetMemoryBudget(size_t worker) const {
+  BOOST_ASSERT(worker < workers_.size());
+
+  return workers_[worker]->memory_budget;
+}
+
+void Instance::SetPinWorkers(bool pin_workers) { pin_workers_ = pin_workers; }
+
+void Instance::CollectStats(StatsHandler handler) {
+  struct Collector {
+    std::mutex mutex;
+    InstanceStats stats;
+    size_t pending;
+  };
+
+  auto collector = std::make_shared<Collector>();
+  collector->pending = workers_.size();
+
+  for (auto &worker : workers_) {
+    Worker *worker_ptr = worker.get();
+    worker->runloop.Post([this, worker_ptr, collector, handler]() {
+      InstanceStats stats;
+      for (auto &manager : worker_ptr->proxy_managers) {
+        stats.tunnels += manager->tunnel_count();
+      }
+      stats.memory = worker_ptr->memory_budget.current();
+      stats.peak_memory = worker_ptr->memory_budget.peak();
+
+      std::lock_guard<std::mutex> lock(collector->mutex);
+      collector->stats.tunnels += stats.tunnels;
+      collector->stats.memory += stats.memory;
+      collector->stats.peak_memory += stats.peak_memory;
+      if (--collector->pending == 0) {
+        GetRunloop()->Post(
+            [collector, handler]() { handler(collector->stats); });
+      }
+    });
+  }
+}
+
+utils::Runloop *Instance::GetRunloop() { return &workers_.front()->runloop; }
 
 }  // namespace nekit
@@ -25,8 +25,20 @@
 #include "nekit/proxy_manager.h"
 #include "nekit/utils/log.h"
 
+#undef NECHANNEL
+#define NECHANNEL "Proxy Manager"
+
 namespace nekit {
-ProxyManager::ProxyManager(utils::Runloop *runloop) : runloop_{runloop} {}
+ProxyManager::ProxyManager(utils::Runloop *runloop)
+    : runloop_{runloop},
+      drain_timer_{runloop,
+                   [this]() {
+                     NEWARN << "Failed to drain in time, closing "
+                            << tunnel_count() << " tunnels.";
+                     tunnel_manager_.CloseAll();
+                     FinishDrain();
+                   }},
+      drain_report_timer_{runloop, [this]() { ReportDrain(); }} {}
 
 void ProxyManager::SetRuleManager(
     std::unique_ptr<rule::RuleManager> &&rule_manager) {
@@ -49,6 +61,18 @@ void ProxyManager::AddListener(
   listeners_.emplace_back(std::move(listener));
 }
 
+void ProxyManager::SetMemoryBudget(utils::MemoryBudget *memory_budget) {
+  tunnel_manager_.SetMemoryBudget(memory_budget);
+}
+
+void ProxyManager::SetTunnelMemoryLimit(size_t limit) {
+  tunnel_manager_.SetTunnelMemoryLimit(limit);
+}
+
+size_t ProxyManager::tunnel_count() const {
+  return tunnel_manager_.tunnel_count();
+}
+
 void ProxyManager::Run() {
   BOOST_ASSERT(rule_manager_);
   BOOST_ASSERT(resolver_);
@@ -74,6 +98,10 @@ void ProxyManager::Run() {
 }
 
 void ProxyManager::Stop() {
+  drain_cancelable_.Cancel();
+  drain_timer_.Cancel();
+  drain_report_timer_.Cancel();
+
   resolver_->Stop();
 
   for (auto &listener : listeners_) {
@@ -81,6 +109,49 @@ void ProxyManager::Stop() {
   }
 }
 
+void ProxyManager::Drain(uint32_t timeout, std::function<void()> handler) {
+  NEINFO << "Start draining " << tunnel_count() << " tunnels.";
+
+  for (auto &listener : listeners_) {
+    listener->Close();
+  }
+
+  drain_handler_ = handler;
+  drain_cancelable_ = utils::Cancelable();
+
+  // The tunnel is still being released when the manager is notified.
+  tunnel_manager_.NotifyWhenEmpty([this, cancelable{drain_cancelable_}]() {
+    runloop_->Post([this, cancelable]() {
+      if (cancelable.canceled()) {
+        return;
+      }
+      FinishDrain();
+    });
+  });
+
+  drain_timer_.Wait(timeout);
+  drain_report_timer_.Wait(NEKIT_DRAIN_REPORT_INTERVAL);
+}
+
+void ProxyManager::ReportDrain() {
+  NEINFO << "Draining, " << tunnel_count() << " tunnels left.";
+  drain_report_timer_.Wait(NEKIT_DRAIN_REPORT_INTERVAL);
+}
+
+void ProxyManager::FinishDrain() {
+  drain_cancelable_.Cancel();
+  drain_timer_.Cancel();
+  drain_report_timer_.Cancel();
+
+  NEINFO << "Finished draining.";
+
+  auto handler = std::move(drain_handler_);
+  drain_handler_ = nullptr;
+  if (handler) {
+    handler();
+  }
+}
+
 utils::Runloop *ProxyManager::GetRunloop() { return runloop_; }
 
 }  // namespace nekit
@@ -0,0 +1,163 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "nekit/transport/sharded_tcp_listener.h"
+
+#if defined(__linux__)
+#include <linux/filter.h>
+#include <sys/socket.h>
+#endif
+
+#include <boost/assert.hpp>
+
+#include "nekit/utils/boost_error.h"
+#include "nekit/utils/log.h"
+
+#undef NECHANNEL
+#define NECHANNEL "Sharded TCP Listener"
+
+namespace nekit {
+namespace transport {
+
+class ShardedTcpListener::ShardListener final : public ListenerInterface {
+ public:
+  ShardListener(std::shared_ptr<ShardedTcpListener> group,
+                TcpListener* listener)
+      : group_{group}, listener_{listener} {}
+
+  void Accept(EventHandler handler) override { listener_->Accept(handler); }
+
+  void Close() override { listener_->Close(); }
+
+  utils::Runloop* GetRunloop() override { return listener_->GetRunloop(); }
+
+ private:
+  std::shared_ptr<ShardedTcpListener> group_;
+  TcpListener* listener_;
+};
+
+ShardedTcpListener::ShardedTcpListener(
+    std::vector<utils::Runloop*> runloops,
+    ListenerInterface::DataFlowHandler handler) {
+  BOOST_ASSERT(!runloops.empty());
+
+  for (auto runloop : runloops) {
+    listeners_.push_back(std::make_unique<TcpListener>(runloop, handler));
+  }
+
+  SetSocketOptions(SocketOptions());
+}
+
+void ShardedTcpListener::SetSocketOptions(const SocketOptions& options) {
+  auto shared_options = std::make_shared<SocketOptions>(options);
+  shared_options->set_reuse_port(true);
+
+  for (auto& listener : listeners_) {
+    listener->SetSocketOptions(shared_options);
+  }
+}
+
+void ShardedTcpListener::SetBacklog(int backlog) {
+  for (auto& listener : listeners_) {
+    listener->SetBacklog(backlog);
+  }
+}
+
+void ShardedTcpListener::SetSteerByCpu(bool steer_by_cpu) {
+  steer_by_cpu_ = steer_by_cpu;
+}
+
+utils::Result<void> ShardedTcpListener::Bind(std::string ip, uint16_t port) {
+  BOOST_ASSERT(port != 0);
+
+  // The sockets join the reuseport group in the order they are bound, which
+  // is the index the steering program selects.
+  for (auto& listener : listeners_) {
+    auto result = listener->Bind(ip, port);
+    if (!result) {
+      for (auto& bound_listener : listeners_) {
+        bound_listener->Close();
+      }
+      return result;
+    }
+  }
+
+  if (steer_by_cpu_) {
+    auto result = AttachCpuSteering();
+    if (!result) {
+      NEWARN << "Failed to steer connections by CPU due to " << result.error()
+             << ", fall back to hashing.";
+    }
+  }
+
+  NEINFO << "Listening on " << ip << ":" << port << " with "
+         << listeners_.size() << " shards.";
+
+  return {};
+}
+
+size_t ShardedTcpListener::shard_count() const { return listeners_.size(); }
+
+std::unique_ptr<ListenerInterface> ShardedTcpListener::Shard(size_t index) {
+  BOOST_ASSERT(index < listeners_.size());
+
+  return std::make_unique<ShardListener>(shared_from_this(),
+                                         listeners_[index].get());
+}
+
+std::vector<TcpListenerStats> ShardedTcpListener::GetStats() {
+  std::vector<TcpListenerStats> stats;
+  for (auto& listener : listeners_) {
+    stats.push_back(listener->GetCounterStats());
+  }
+  return stats;
+}
+
+utils::Result<void> ShardedTcpListener::AttachCpuSteering() {
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+  // A = current CPU; A %= number of shards; return A
+  struct sock_filter code[] = {
+      {BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU)},
+      {BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)listeners_.size()},
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog program = {sizeof(code) / sizeof(code[0]), code};
+
+  // The program is shared by the whole group, attaching it to any member is
+  // enough.
+  if (setsockopt(listeners_.front()->acceptor_.native_handle(), SOL_SOCKET,
+                 SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) != 0) {
+    return utils::MakeErrorResult(utils::BoostErrorCategory::FromBoostError(
+        boost::system::error_code(errno, boost::system::system_category())));
+  }
+
+  NEDEBUG << "Steering connections to " << listeners_.size()
+          << " shards by CPU.";
+  return {};
+#else
+  return utils::MakeErrorResult(utils::BoostErrorCategory::FromBoostError(
+      boost::asio::error::no_protocol_option));
+#endif
+}
+
+}  // namespace transport
+}  // namespace nekit
@@ -0,0 +1,232 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "nekit/transport/socket_options.h"
+
+#include "nekit/utils/log.h"
+
+#undef NECHANNEL
+#define NECHANNEL "Socket Options"
+
+namespace nekit {
+namespace transport {
+
+namespace {
+template <int Name>
+using TcpIntegerOption =
+    boost::asio::detail::socket_option::integer<IPPROTO_TCP, Name>;
+
+template <typename Socket, typename Option>
+void SetOption(Socket* socket, const Option& option, const char* name) {
+  boost::system::error_code ec;
+  socket->set_option(option, ec);
+  if (ec) {
+    NEWARN << "Failed to set " << name << " due to " << ec << ".";
+  }
+}
+}  // namespace
+
+SocketOptions& SocketOptions::set_no_delay(bool no_delay) {
+  no_delay_ = no_delay;
+  return *this;
+}
+
+SocketOptions& SocketOptions::set_receive_buffer_size(int size) {
+  receive_buffer_size_ = size;
+  return *this;
+}
+
+SocketOptions& SocketOptions::set_send_buffer_size(int size) {
+  send_buffer_size_ = size;
+  return *this;
+}
+
+SocketOptions& SocketOptions::set_not_sent_low_watermark(int size) {
+  not_sent_low_watermark_ = size;
+  return *this;
+}
+
+SocketOptions& SocketOptions::set_keep_alive(int idle, int interval,
+                                             int count) {
+  keep_alive_ = KeepAlive{idle, interval, count};
+  return *this;
+}
+
+SocketOptions& SocketOptions::set_quick_ack(bool quick_ack) {
+  quick_ack_ = quick_ack;
+  return *this;
+}
+
+SocketOptions& SocketOptions::set_user_timeout(unsigned int timeout) {
+  user_timeout_ = timeout;
+  return *this;
+}
+
+SocketOptions& SocketOptions::set_fast_open_queue_length(int queue_length) {
+  fast_open_queue_length_ = queue_length;
+  return *this;
+}
+
+SocketOptions& SocketOptions::set_fast_open_connect(bool fast_open_connect) {
+  fast_open_connect_ = fast_open_connect;
+  return *this;
+}
+
+SocketOptions& SocketOptions::set_zero_copy(bool zero_copy) {
+  zero_copy_ = zero_copy;
+  return *this;
+}
+
+SocketOptions& SocketOptions::set_reuse_port(bool reuse_port) {
+  reuse_port_ = reuse_port;
+  return *this;
+}
+
+bool SocketOptions::fast_open_enabled() const {
+  return (fast_open_queue_length_ && *fast_open_queue_length_ > 0) ||
+         (fast_open_connect_ && *fast_open_connect_);
+}
+
+template <typename Socket>
+void SocketOptions::DoApply(Socket* socket) const {
+  if (no_delay_) {
+    SetOption(socket, boost::asio::ip::tcp::no_delay(*no_delay_),
+              "TCP_NODELAY");
+  }
+
+  if (receive_buffer_size_) {
+    SetOption(socket,
+              boost::asio::socket_base::receive_buffer_size(
+                  *receive_buffer_size_),
+              "SO_RCVBUF");
+  }
+
+  if (send_buffer_size_) {
+    SetOption(socket,
+              boost::asio::socket_base::send_buffer_size(*send_buffer_size_),
+              "SO_SNDBUF");
+  }
+
+  if (not_sent_low_watermark_) {
+#if defined(TCP_NOTSENT_LOWAT)
+    SetOption(socket,
+              TcpIntegerOption<TCP_NOTSENT_LOWAT>(*not_sent_low_watermark_),
+              "TCP_NOTSENT_LOWAT");
+#else
+    NEDEBUG << "TCP_NOTSENT_LOWAT is not supported.";
+#endif
+  }
+
+  if (keep_alive_) {
+    SetOption(socket, boost::asio::socket_base::keep_alive(true),
+              "SO_KEEPALIVE");
+#if defined(TCP_KEEPIDLE)
+    SetOption(socket, TcpIntegerOption<TCP_KEEPIDLE>(keep_alive_->idle),
+              "TCP_KEEPIDLE");
+#elif defined(TCP_KEEPALIVE)
+    SetOption(socket, TcpIntegerOption<TCP_KEEPALIVE>(keep_alive_->idle),
+              "TCP_KEEPALIVE");
+#endif
+#if defined(TCP_KEEPINTVL)
+    SetOption(socket, TcpIntegerOption<TCP_KEEPINTVL>(keep_alive_->interval),
+              "TCP_KEEPINTVL");
+#endif
+#if defined(TCP_KEEPCNT)
+    SetOption(socket, TcpIntegerOption<TCP_KEEPCNT>(keep_alive_->count),
+              "TCP_KEEPCNT");
+#endif
+  }
+
+  if (quick_ack_) {
+#if defined(TCP_QUICKACK)
+    SetOption(socket, TcpIntegerOption<TCP_QUICKACK>(*quick_ack_),
+              "TCP_QUICKACK");
+#else
+    NEDEBUG << "TCP_QUICKACK is not supported.";
+#endif
+  }
+
+  if (user_timeout_) {
+#if defined(TCP_USER_TIMEOUT)
+    SetOption(socket,
+              TcpIntegerOption<TCP_USER_TIMEOUT>(
+                  static_cast<int>(*user_timeout_)),
+              "TCP_USER_TIMEOUT");
+#else
+    NEDEBUG << "TCP_USER_TIMEOUT is not supported.";
+#endif
+  }
+
+  if (zero_copy_) {
+#if defined(SO_ZEROCOPY)
+    SetOption(socket,
+              boost::asio::detail::socket_option::boolean<SOL_SOCKET,
+                                                          SO_ZEROCOPY>(
+                  *zero_copy_),
+              "SO_ZEROCOPY");
+#else
+    NEDEBUG << "SO_ZEROCOPY is not supported.";
+#endif
+  }
+}
+
+void SocketOptions::Apply(boost::asio::ip::tcp::socket* socket) const {
+  DoApply(socket);
+
+  if (fast_open_connect_) {
+#if defined(TCP_FASTOPEN_CONNECT)
+    SetOption(socket,
+              TcpIntegerOption<TCP_FASTOPEN_CONNECT>(*fast_open_connect_),
+              "TCP_FASTOPEN_CONNECT");
+#else
+    NEDEBUG << "TCP_FASTOPEN_CONNECT is not supported.";
+#endif
+  }
+}
+
+void SocketOptions::Apply(boost::asio::ip::tcp::acceptor* acceptor) const {
+  DoApply(acceptor);
+
+  if (fast_open_queue_length_) {
+#if defined(TCP_FASTOPEN)
+    SetOption(acceptor,
+              TcpIntegerOption<TCP_FASTOPEN>(*fast_open_queue_length_),
+              "TCP_FASTOPEN");
+#else
+    NEDEBUG << "TCP_FASTOPEN is not supported.";
+#endif
+  }
+
+  if (reuse_port_) {
+#if defined(SO_REUSEPORT)
+    SetOption(acceptor,
+              boost::asio::detail::socket_option::boolean<SOL_SOCKET,
+                                                          SO_REUSEPORT>(
+                  *reuse_port_),
+              "SO_REUSEPORT");
+#else
+    NEDEBUG << "SO_REUSEPORT is not supported.";
+#endif
+  }
+}
+}  // namespace transport
+}  // namespace nekit
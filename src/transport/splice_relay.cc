@@ -0,0 +1,245 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "nekit/transport/splice_relay.h"
+
+#include <cerrno>
+#include <cstddef>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "nekit/config.h"
+#include "nekit/transport/tcp_socket.h"
+#include "nekit/utils/boost_error.h"
+#include "nekit/utils/log.h"
+
+#undef NECHANNEL
+#define NECHANNEL "Splice Relay"
+
+namespace nekit {
+namespace transport {
+
+namespace {
+#if defined(__linux__)
+bool OpenPipe(int fds[2]) { return !pipe2(fds, O_NONBLOCK | O_CLOEXEC); }
+
+void ClosePipe(int fds[2]) {
+  for (int i = 0; i < 2; i++) {
+    if (fds[i] != -1) {
+      close(fds[i]);
+      fds[i] = -1;
+    }
+  }
+}
+
+std::ptrdiff_t Splice(int from, int to, size_t len) {
+  return splice(from, nullptr, to, nullptr, len,
+                SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+}
+#else
+bool OpenPipe(int fds[2]) {
+  (void)fds;
+  return false;
+}
+
+void ClosePipe(int fds[2]) { (void)fds; }
+
+std::ptrdiff_t Splice(int from, int to, size_t len) {
+  (void)from;
+  (void)to;
+  (void)len;
+  errno = ENOSYS;
+  return -1;
+}
+#endif
+
+int NativeHandle(boost::asio::ip::tcp::socket* socket) {
+  return static_cast<int>(socket->native_handle());
+}
+
+utils::Error ErrorFromErrno() {
+  return utils::BoostErrorCategory::FromBoostError(
+      boost::system::error_code{errno, boost::system::system_category()});
+}
+}  // namespace
+
+std::unique_ptr<SpliceRelay> SpliceRelay::Create(
+    utils::Runloop* runloop, boost::asio::ip::tcp::socket* local,
+    boost::asio::ip::tcp::socket* remote) {
+  std::unique_ptr<SpliceRelay> relay{new SpliceRelay(runloop, local, remote)};
+
+  for (auto& direction : relay->directions_) {
+    if (!OpenPipe(direction.pipe)) {
+      NEDEBUG << "Failed to create pipe for splice relay.";
+      return nullptr;
+    }
+  }
+
+  boost::system::error_code ec;
+  local->native_non_blocking(true, ec);
+  if (!ec) {
+    remote->native_non_blocking(true, ec);
+  }
+  if (ec) {
+    NEDEBUG << "Failed to set socket non-blocking due to " << ec << ".";
+    return nullptr;
+  }
+
+  return relay;
+}
+
+boost::asio::ip::tcp::socket* SpliceRelay::FindSocket(
+    data_flow::DataFlowInterface* flow) {
+  while (flow && flow->IsPassThrough()) {
+    flow = flow->NextHop();
+  }
+
+  auto socket = dynamic_cast<TcpSocket*>(flow);
+  if (!socket) {
+    return nullptr;
+  }
+  return socket->BoostSocket();
+}
+
+SpliceRelay::SpliceRelay(utils::Runloop* runloop,
+                         boost::asio::ip::tcp::socket* local,
+                         boost::asio::ip::tcp::socket* remote)
+    : runloop_{runloop} {
+  directions_[0].from = local;
+  directions_[0].to = remote;
+  directions_[1].from = remote;
+  directions_[1].to = local;
+}
+
+SpliceRelay::~SpliceRelay() {
+  cancelable_.Cancel();
+
+  for (auto& direction : directions_) {
+    ClosePipe(direction.pipe);
+  }
+}
+
+void SpliceRelay::Relay(std::function<void()> progress_handler,
+                        EventHandler handler) {
+  progress_handler_ = progress_handler;
+  handler_ = handler;
+  cancelable_ = utils::Cancelable();
+
+  for (auto& direction : directions_) {
+    Wait(&direction, direction.from, boost::asio::socket_base::wait_read);
+  }
+}
+
+uint64_t SpliceRelay::relayed_bytes() const { return relayed_bytes_; }
+
+void SpliceRelay::Pump(Direction* direction) {
+  for (int i = 0; i < NEKIT_SPLICE_RELAY_BATCH_COUNT; i++) {
+    if (direction->pending) {
+      auto len = Splice(direction->pipe[0], NativeHandle(direction->to),
+                        direction->pending);
+      if (len < 0) {
+        if (errno == EAGAIN) {
+          Wait(direction, direction->to, boost::asio::socket_base::wait_write);
+        } else {
+          Finish(utils::MakeErrorResult(ErrorFromErrno()));
+        }
+        return;
+      }
+
+      direction->pending -= len;
+      relayed_bytes_ += len;
+      progress_handler_();
+      continue;
+    }
+
+    if (direction->eof) {
+      NEDEBUG << "Got EOF, close writing of the other side.";
+
+      boost::system::error_code ec;
+      direction->to->shutdown(boost::asio::socket_base::shutdown_send, ec);
+      direction->finished = true;
+      if (directions_[0].finished && directions_[1].finished) {
+        Finish({});
+      }
+      return;
+    }
+
+    auto len = Splice(NativeHandle(direction->from), direction->pipe[1],
+                      NEKIT_SPLICE_RELAY_SIZE);
+    if (len < 0) {
+      if (errno == EAGAIN) {
+        Wait(direction, direction->from, boost::asio::socket_base::wait_read);
+      } else {
+        Finish(utils::MakeErrorResult(ErrorFromErrno()));
+      }
+      return;
+    }
+
+    if (len == 0) {
+      direction->eof = true;
+      continue;
+    }
+    direction->pending += len;
+  }
+
+  // Let other connections on the runloop run before continuing.
+  runloop_->Post([this, direction, cancelable{cancelable_}]() {
+    if (cancelable.canceled()) {
+      return;
+    }
+
+    Pump(direction);
+  });
+}
+
+void SpliceRelay::Wait(Direction* direction,
+                       boost::asio::ip::tcp::socket* socket,
+                       boost::asio::socket_base::wait_type type) {
+  socket->async_wait(type, [this, direction, cancelable{cancelable_}](
+                               const boost::system::error_code& ec) {
+    if (cancelable.canceled()) {
+      return;
+    }
+
+    if (ec) {
+      Finish(utils::MakeErrorResult(
+          utils::BoostErrorCategory::FromBoostError(ec)));
+      return;
+    }
+
+    Pump(direction);
+  });
+}
+
+void SpliceRelay::Finish(utils::Result<void>&& result) {
+  // The other direction may still be waiting.
+  cancelable_.Cancel();
+
+  // The relay may be released in the handler.
+  auto handler = std::move(handler_);
+  handler(std::move(result));
+}
+}  // namespace transport
+}  // namespace nekit
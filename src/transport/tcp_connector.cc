@@ -130,6 +130,11 @@ void TcpConnector::Bind(std::shared_ptr<utils::DeviceInterface> device) {
   device_ = device;
 }
 
+void TcpConnector::SetSocketOptions(
+    std::shared_ptr<const SocketOptions> options) {
+  socket_options_ = options;
+}
+
 void TcpConnector::DoConnect(EventHandler handler) {
   connecting_ = true;
 
@@ -158,8 +163,24 @@ void TcpConnector::DoConnect(EventHandler handler) {
     address = &address_;
   }
 
+  boost::asio::ip::tcp::endpoint endpoint{*address, port_};
+
+  if (socket_options_) {
+    socket_.open(endpoint.protocol(), ec);
+    if (ec) {
+      NEDEBUG << "Failed to open socket due to " << ec
+              << ", trying next address.";
+      last_error_ = ec;
+      current_ind_++;
+      DoConnect(handler);
+      return;
+    }
+
+    socket_options_->Apply(&socket_);
+  }
+
   socket_.async_connect(
-      boost::asio::ip::tcp::endpoint(*address, port_),
+      endpoint,
       [this, handler,
        cancelable{cancelable_}](const boost::system::error_code& ec) mutable {
         if (cancelable.canceled()) {
@@ -22,9 +22,16 @@
 
 #include "nekit/transport/tcp_listener.h"
 
+#if defined(__linux__)
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
 #include "nekit/transport/tcp_socket.h"
 #include "nekit/utils/boost_error.h"
 #include "nekit/utils/log.h"
+#include "nekit/utils/pool_allocator.h"
 
 #undef NECHANNEL
 #define NECHANNEL "TCP Listener"
@@ -37,6 +44,15 @@ TcpListener::TcpListener(utils::Runloop *runloop, DataFlowHandler handler)
       runloop_{runloop},
       handler_{handler} {}
 
+TcpListener::~TcpListener() { accept_cancelable_.Cancel(); }
+
+void TcpListener::SetSocketOptions(
+    std::shared_ptr<const SocketOptions> options) {
+  socket_options_ = options;
+}
+
+void TcpListener::SetBacklog(int backlog) { backlog_ = backlog; }
+
 utils::Result<void> TcpListener::Bind(std::string ip, uint16_t port) {
   return Bind(boost::asio::ip::address::from_string(ip), port);
 }
@@ -64,6 +80,10 @@ utils::Result<void> TcpListener::Bind(boost::asio::ip::address ip,
     return utils::MakeErrorResult(std::move(error));
   }
 
+  if (socket_options_) {
+    socket_options_->Apply(&acceptor_);
+  }
+
   acceptor_.bind(endpoint, ec);
   if (ec) {
     utils::Error error;
@@ -78,28 +98,64 @@ utils::Result<void> TcpListener::Bind(boost::asio::ip::address ip,
     return utils::MakeErrorResult(std::move(error));
   }
 
-  acceptor_.listen(8, ec);
+  acceptor_.listen(backlog_, ec);
   if (ec) {
     error = utils::BoostErrorCategory::FromBoostError(ec);
     NEERROR << "Failed to set listener to listen state due to " << error << ".";
     return utils::MakeErrorResult(std::move(error));
   }
 
+  // The connections are accepted without blocking in batches.
+  acceptor_.non_blocking(true, ec);
+  if (ec) {
+    error = utils::BoostErrorCategory::FromBoostError(ec);
+    NEERROR << "Failed to set listener to non-blocking due to " << error
+            << ".";
+    return utils::MakeErrorResult(std::move(error));
+  }
+
+  endpoint_ = endpoint;
+
   NEINFO << "Successfully bind TCP listener to " << endpoint << ".";
 
   return {};
 }
 
+boost::asio::ip::tcp::endpoint TcpListener::local_endpoint() const {
+  boost::system::error_code ec;
+  return acceptor_.local_endpoint(ec);
+}
+
 void TcpListener::Accept(EventHandler handler) {
   NEDEBUG << "Start accepting new socket.";
 
-  acceptor_.async_accept(
-      socket_, [this, handler](const boost::system::error_code &ec) {
+  accept_cancelable_ = utils::Cancelable();
+
+  // Connections may be waiting already.
+  runloop_->Post([this, handler, cancelable{accept_cancelable_}]() {
+    if (cancelable.canceled()) {
+      return;
+    }
+
+    AcceptBatch(handler);
+  });
+}
+
+void TcpListener::WaitForAccept(EventHandler handler) {
+  acceptor_.async_wait(
+      boost::asio::ip::tcp::acceptor::wait_read,
+      [this, handler,
+       cancelable{accept_cancelable_}](const boost::system::error_code &ec) {
+        if (cancelable.canceled()) {
+          return;
+        }
+
         if (ec) {
           if (ec.value() == boost::asio::error::operation_aborted) {
             return;
           }
 
+          counters_.errors++;
           utils::Error error = utils::BoostErrorCategory::FromBoostError(ec);
           NEERROR << "Failed to accept new socket due to " << error << ".";
 
@@ -107,19 +163,141 @@ void TcpListener::Accept(EventHandler handler) {
           return;
         }
 
-        NEINFO << "Accepted new TCP socket.";
+        AcceptBatch(handler);
+      });
+}
 
-        // Can't use `make_unique` since the constructor is a private friend.
-        TcpSocket *socket = new TcpSocket(
-            std::move(socket_), std::make_shared<utils::Session>(runloop_));
+void TcpListener::AcceptBatch(EventHandler handler) {
+  // The listener may be closed in the handler.
+  auto cancelable = accept_cancelable_;
 
-        handler(handler_(std::unique_ptr<TcpSocket>(socket)));
+  counters_.batches++;
 
-        Accept(handler);
-      });
+  size_t count = 0;
+  while (count < NEKIT_TCP_LISTENER_ACCEPT_BATCH_SIZE) {
+    boost::system::error_code ec;
+    AcceptSocket(&ec);
+
+    if (ec == boost::asio::error::would_block ||
+        ec == boost::asio::error::try_again) {
+      WaitForAccept(handler);
+      return;
+    }
+
+    // The connection is reset before it is accepted.
+    if (ec == boost::asio::error::connection_aborted ||
+        ec == boost::asio::error::interrupted) {
+      continue;
+    }
+
+    if (ec) {
+      if (ec.value() == boost::asio::error::bad_descriptor &&
+          !acceptor_.is_open()) {
+        return;
+      }
+
+      counters_.errors++;
+      utils::Error error = utils::BoostErrorCategory::FromBoostError(ec);
+      NEERROR << "Failed to accept new socket due to " << error << ".";
+
+      handler(utils::MakeErrorResult(std::move(error)));
+      return;
+    }
+
+    count++;
+    counters_.accepted++;
+
+    HandleSocket(handler);
+    if (cancelable.canceled() || !acceptor_.is_open()) {
+      return;
+    }
+  }
+
+  NEDEBUG << "Accepted " << count
+          << " sockets in a batch, continue after other events.";
+
+  counters_.full_batches++;
+
+  runloop_->Post([this, handler, cancelable]() {
+    if (cancelable.canceled()) {
+      return;
+    }
+
+    AcceptBatch(handler);
+  });
+}
+
+void TcpListener::AcceptSocket(boost::system::error_code *ec) {
+#if defined(__linux__)
+  int fd = ::accept4(acceptor_.native_handle(), nullptr, nullptr,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if (fd < 0) {
+    *ec = boost::system::error_code(errno,
+                                    boost::asio::error::get_system_category());
+    return;
+  }
+
+  socket_.assign(endpoint_.protocol(), fd, *ec);
+  if (*ec) {
+    ::close(fd);
+  }
+#else
+  acceptor_.accept(socket_, *ec);
+#endif
 }
 
-void TcpListener::Close() { acceptor_.close(); }
+void TcpListener::HandleSocket(EventHandler handler) {
+  NEINFO << "Accepted new TCP socket.";
+
+  if (socket_options_) {
+    socket_options_->Apply(&socket_);
+  }
+
+  // Can't use `make_unique` since the constructor is a private friend.
+  TcpSocket *socket = new TcpSocket(
+      std::move(socket_),
+      std::allocate_shared<utils::Session>(
+          utils::PoolAllocator<utils::Session>(), runloop_));
+
+  if (socket_options_ && socket_options_->fast_open_enabled()) {
+    socket->CountFastOpenAccept();
+  }
+
+  handler(handler_(std::unique_ptr<TcpSocket>(socket)));
+}
+
+TcpListenerStats TcpListener::GetCounterStats() const {
+  TcpListenerStats stats;
+  stats.accepted = counters_.accepted;
+  stats.batches = counters_.batches;
+  stats.full_batches = counters_.full_batches;
+  stats.errors = counters_.errors;
+  return stats;
+}
+
+TcpListenerStats TcpListener::GetStats() {
+  TcpListenerStats stats = GetCounterStats();
+
+#if defined(__linux__)
+  // For a listening socket, the accept queue length and size are reported
+  // as the unacknowledged and selectively acknowledged segments.
+  struct tcp_info info;
+  socklen_t len = sizeof(info);
+  if (acceptor_.is_open() &&
+      getsockopt(acceptor_.native_handle(), IPPROTO_TCP, TCP_INFO, &info,
+                 &len) == 0) {
+    stats.queue_length = info.tcpi_unacked;
+    stats.backlog = info.tcpi_sacked;
+  }
+#endif
+
+  return stats;
+}
+
+void TcpListener::Close() {
+  accept_cancelable_.Cancel();
+  acceptor_.close();
+}
 
 utils::Runloop *TcpListener::GetRunloop() { return runloop_; }
 
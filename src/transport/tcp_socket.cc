@@ -20,11 +20,21 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#include <netinet/tcp.h>
+#endif
+
 #include <boost/assert.hpp>
 
 #include "nekit/config.h"
 #include "nekit/transport/tcp_socket.h"
 #include "nekit/utils/boost_error.h"
+#include "nekit/utils/buffer_sequence.h"
 #include "nekit/utils/common_error.h"
 #include "nekit/utils/error.h"
 #include "nekit/utils/log.h"
@@ -32,9 +42,29 @@
 #undef NECHANNEL
 #define NECHANNEL "TCP Socket"
 
+#if defined(__linux__) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+#define NE_TCP_ZERO_COPY 1
+#else
+#define NE_TCP_ZERO_COPY 0
+#endif
+
 namespace nekit {
 namespace transport {
 
+namespace {
+TcpSocketStats& MutableStats() {
+  static TcpSocketStats stats;
+  return stats;
+}
+
+#if defined(__linux__)
+bool GetTcpInfo(int fd, struct tcp_info* info) {
+  socklen_t len = sizeof(*info);
+  return getsockopt(fd, IPPROTO_TCP, TCP_INFO, info, &len) == 0;
+}
+#endif
+}  // namespace
+
 std::string TcpErrorCategory::Description(const utils::Error &error) const {
   switch ((TcpErrorCode)error.ErrorCode()) {
     case TcpErrorCode::ConnectionAborted:
@@ -65,29 +95,38 @@ TcpSocket::TcpSocket(boost::asio::ip::tcp::socket &&socket,
                      std::shared_ptr<utils::Session> session)
     : socket_{std::move(socket)},
       session_{session},
-      write_buffer_{
-          std::make_unique<std::vector<boost::asio::const_buffer>>(0)},
-      read_buffer_{
-          std::make_unique<std::vector<boost::asio::mutable_buffer>>(0)},
       state_machine_{data_flow::FlowType::Local} {
   BOOST_ASSERT(&socket_.get_io_context() ==
                session->GetRunloop()->BoostIoContext());
 }
 
-TcpSocket::TcpSocket(std::shared_ptr<utils::Session> session)
+TcpSocket::TcpSocket(std::shared_ptr<utils::Session> session,
+                     std::shared_ptr<const SocketOptions> options)
     : socket_{*session->GetRunloop()->BoostIoContext()},
       session_{session},
-      write_buffer_{
-          std::make_unique<std::vector<boost::asio::const_buffer>>(0)},
-      read_buffer_{
-          std::make_unique<std::vector<boost::asio::mutable_buffer>>(0)},
+      socket_options_{options},
       state_machine_{data_flow::FlowType::Remote} {}
 
 TcpSocket::~TcpSocket() {
   read_cancelable_.Cancel();
   write_cancelable_.Cancel();
+  close_cancelable_.Cancel();
   report_cancelable_.Cancel();
   connect_cancelable_.Cancel();
+  zero_copy_cancelable_.Cancel();
+
+  if (!zero_copy_writes_.empty()) {
+    // The system may still read the memory of the writes, closing the socket
+    // does not stop it from sending the queued data.
+    NEDEBUG << "Wait for " << zero_copy_writes_.size()
+            << " zero copy writes to complete before closing.";
+
+    boost::system::error_code ec;
+    socket_.cancel(ec);
+    socket_.shutdown(socket_.shutdown_both, ec);
+    WaitForZeroCopyLinger(std::make_shared<ZeroCopyLinger>(ZeroCopyLinger{
+        std::move(socket_), std::move(zero_copy_writes_)}));
+  }
 }
 
 utils::Cancelable TcpSocket::Read(DataEventHandler handler) {
@@ -95,117 +134,435 @@ utils::Cancelable TcpSocket::Read(DataEventHandler handler) {
 
   read_cancelable_ = utils::Cancelable();
 
-  utils::Buffer buffer{NEKIT_TCP_SOCKET_READ_SIZE};
-  buffer.WalkInternalChunk(
-      [this](void *d, size_t s, void *c) {
-        (void)c;
-        read_buffer_->push_back(boost::asio::mutable_buffer(d, s));
-        return true;
-      },
-      0, nullptr);
-
   state_machine_.ReadBegin();
 
-  socket_.async_read_some(
-      *read_buffer_,
-      [this, buffer{std::move(buffer)}, buffer_wrapper{std::move(read_buffer_)},
-       handler,
-       cancelable{read_cancelable_}](const boost::system::error_code &ec,
-                                     std::size_t bytes_transferred) mutable {
+  StartDeferredConnect();
+
+  // The data is often available already, e.g., the response to a request just
+  // sent, so try reading before waiting for the socket to be readable. After a
+  // miss, wait until a read completes through the wait before trying again.
+  if (!speculate_read_) {
+    WaitForRead(handler);
+    return read_cancelable_;
+  }
+
+  MutableStats().speculative_reads++;
+
+  utils::Buffer buffer;
+  boost::system::error_code ec;
+  if (!TryRead(&buffer, &ec)) {
+    MutableStats().speculative_read_misses++;
+    speculate_read_ = false;
+    WaitForRead(handler);
+    return read_cancelable_;
+  }
+
+  MutableStats().speculative_read_hits++;
+
+  // The handler is never called before `Read` returns.
+  GetRunloop()->Post([this, handler, buffer{std::move(buffer)}, ec,
+                      cancelable{read_cancelable_}]() mutable {
+    if (cancelable.canceled()) {
+      return;
+    }
+
+    FinishRead(std::move(buffer), ec, handler);
+  });
+
+  return read_cancelable_;
+}
+
+void TcpSocket::WaitForRead(DataEventHandler handler) {
+  socket_.async_wait(
+      boost::asio::ip::tcp::socket::wait_read,
+      [this, handler,
+       cancelable{read_cancelable_}](const boost::system::error_code &ec) {
         if (cancelable.canceled()) {
           return;
         }
 
-        state_machine_.ReadEnd();
-
         if (ec) {
-          auto error = ConvertBoostError(ec);
-
-          if (utils::CommonErrorCategory::IsEof(error)) {
-            state_machine_.ReadClosed();
-            NEDEBUGT << "Socket got EOF.";
-          } else {
-            NEERRORT << "Reading from socket failed due to " << error << ".";
-            state_machine_.Errored();
-            // report and connect cancelable should not be in use.
-            write_cancelable_.Cancel();
-          }
-
-          handler(utils::MakeErrorResult(std::move(error)));
+          ReportReadError(ec, handler);
           return;
         }
 
-        NETRACE << "Successfully read " << bytes_transferred
-                << " bytes from socket.";
-
-        if (bytes_transferred != buffer.size()) {
-          buffer.ShrinkBack(buffer.size() - bytes_transferred);
+        utils::Buffer buffer;
+        boost::system::error_code read_ec;
+        if (!TryRead(&buffer, &read_ec)) {
+          NETRACE << "Socket is not readable yet, wait again.";
+          WaitForRead(handler);
+          return;
         }
 
-        read_buffer_ = std::move(buffer_wrapper);
-        read_buffer_->clear();
+        speculate_read_ = true;
 
-        handler(std::move(buffer));
-        return;
+        FinishRead(std::move(buffer), read_ec, handler);
       });
-  return read_cancelable_;
+}
+
+bool TcpSocket::TryRead(utils::Buffer *buffer, boost::system::error_code *ec) {
+  if (!EnsureNonBlocking(ec)) {
+    return true;
+  }
+
+  // Peek one byte first so no buffer is allocated when there is no data.
+  // EOF and errors are reported by the peek as well.
+  uint8_t byte;
+  socket_.receive(boost::asio::buffer(&byte, 1),
+                  boost::asio::socket_base::message_peek, *ec);
+  if (*ec == boost::asio::error::would_block ||
+      *ec == boost::asio::error::try_again) {
+    return false;
+  }
+
+  if (*ec) {
+    return true;
+  }
+
+  *buffer = utils::Buffer{ReadBufferSize(), read_reserve_size_};
+  size_t bytes_transferred =
+      socket_.read_some(utils::MutableBufferSequence{*buffer}, *ec);
+
+  if (*ec) {
+    *buffer = utils::Buffer();
+    return true;
+  }
+
+  AdaptReadSize(bytes_transferred, buffer->size());
+
+  if (bytes_transferred != buffer->size()) {
+    buffer->ShrinkBack(buffer->size() - bytes_transferred);
+  }
+
+  return true;
+}
+
+void TcpSocket::FinishRead(utils::Buffer &&buffer,
+                           const boost::system::error_code &ec,
+                           DataEventHandler handler) {
+  if (ec) {
+    ReportReadError(ec, handler);
+    return;
+  }
+
+  state_machine_.ReadEnd();
+
+  NETRACE << "Successfully read " << buffer.size() << " bytes from socket.";
+
+  // The handshake is done once there is data to read.
+  if (fast_open_state_ == FastOpenState::Sent) {
+    fast_open_state_ = FastOpenState::None;
+    if (IsSynDataAcked()) {
+      MutableStats().fast_open_syn_data_acked++;
+    } else {
+      NEDEBUG << "Server did not accept data in SYN.";
+    }
+  }
+
+  handler(std::move(buffer));
+}
+
+bool TcpSocket::EnsureNonBlocking(boost::system::error_code *ec) {
+  if (!socket_.non_blocking()) {
+    socket_.non_blocking(true, *ec);
+  }
+  return !*ec;
+}
+
+void TcpSocket::ReportReadError(const boost::system::error_code &ec,
+                                DataEventHandler handler) {
+  state_machine_.ReadEnd();
+
+  auto error = ConvertBoostError(ec);
+
+  if (utils::CommonErrorCategory::IsEof(error)) {
+    state_machine_.ReadClosed();
+    NEDEBUGT << "Socket got EOF.";
+  } else {
+    NEERRORT << "Reading from socket failed due to " << error << ".";
+    state_machine_.Errored();
+    // report and connect cancelable should not be in use.
+    write_cancelable_.Cancel();
+  }
+
+  handler(utils::MakeErrorResult(std::move(error)));
+}
+
+size_t TcpSocket::ReadBufferSize() const {
+  size_t reserve_size =
+      read_reserve_size_.prefix() + read_reserve_size_.suffix();
+  return read_size_ - std::min(reserve_size, read_size_ / 2);
+}
+
+void TcpSocket::AdaptReadSize(size_t bytes_transferred, size_t buffer_size) {
+  if (bytes_transferred == buffer_size) {
+    read_size_ =
+        std::min<size_t>(read_size_ * 2, NEKIT_TCP_SOCKET_MAX_READ_SIZE);
+  } else if (bytes_transferred * 4 < read_size_) {
+    read_size_ =
+        std::max<size_t>(read_size_ / 2, NEKIT_TCP_SOCKET_MIN_READ_SIZE);
+  }
 }
 
 utils::Cancelable TcpSocket::Write(utils::Buffer &&buffer,
                                    EventHandler handler) {
-  NETRACE << "Start writing data.";
+  NETRACE << "Queue " << buffer.size() << " bytes to write.";
+
+  BOOST_ASSERT(state_machine_.IsWritable());
+
+  utils::Cancelable cancelable;
+  write_queue_.push_back(PendingWrite{buffer.size(), handler, cancelable});
+  write_buffer_.InsertBack(std::move(buffer));
+
+  UpdateWritable();
+  ScheduleFlush();
+
+  return cancelable;
+}
+
+void TcpSocket::ScheduleFlush() {
+  if (flushing_ || flush_scheduled_) {
+    return;
+  }
+
+  if (!cork_) {
+    Flush();
+    return;
+  }
+
+  flush_scheduled_ = true;
+  GetRunloop()->Post([this, cancelable{write_cancelable_}]() {
+    if (cancelable.canceled()) {
+      return;
+    }
+
+    flush_scheduled_ = false;
+    Flush();
+  });
+}
+
+void TcpSocket::Flush() {
+  if (flushing_ || write_queue_.empty()) {
+    return;
+  }
+
+  flushing_ = true;
+
+  // The first write of a deferred connection is sent with the SYN.
+  if (fast_open_state_ == FastOpenState::Deferred) {
+    fast_open_state_ = FastOpenState::Sent;
+  }
+
+  // New writes are queued in `write_buffer_` while this one is in progress.
+  utils::Buffer buffer = std::move(write_buffer_);
+  writing_bytes_ = buffer.size();
+  utils::ConstBufferSequence sequence{buffer};
+
+  bool zero_copy = ShouldZeroCopy(writing_bytes_);
+  boost::asio::socket_base::message_flags flags = 0;
+#if NE_TCP_ZERO_COPY
+  if (zero_copy) {
+    flags = MSG_ZEROCOPY;
+  }
+#endif
+
+  NETRACE << "Start writing " << writing_bytes_ << " bytes of "
+          << write_queue_.size() << " writes"
+          << (zero_copy ? " without copying." : ".");
+
+  // Try sending right away, there is usually space in the send buffer.
+  MutableStats().speculative_writes++;
 
-  write_cancelable_ = utils::Cancelable();
+  boost::system::error_code ec;
+  size_t bytes_transferred = 0;
+  if (EnsureNonBlocking(&ec)) {
+    bytes_transferred = socket_.send(sequence, flags, ec);
+  }
 
-  buffer.WalkInternalChunk(
-      [this](void *d, size_t s, void *c) {
-        (void)c;
-        write_buffer_->emplace_back(d, s);
-        return true;
-      },
-      0, nullptr);
+  if (ec != boost::asio::error::would_block &&
+      ec != boost::asio::error::try_again) {
+    // The memory of a zero copy send must be held even if the socket is
+    // released before the completion runs.
+    if (!ec) {
+      MutableStats().speculative_write_hits++;
+      ConsumeSent(&buffer, bytes_transferred, zero_copy);
+    }
 
-  state_machine_.WriteBegin();
+    GetRunloop()->Post([this, buffer{std::move(buffer)}, zero_copy, ec,
+                        bytes_transferred,
+                        cancelable{write_cancelable_}]() mutable {
+      if (cancelable.canceled()) {
+        return;
+      }
 
-  boost::asio::async_write(
-      socket_, *write_buffer_,
-      [this, buffer{std::move(buffer)}, handler, cancelable{write_cancelable_}](
-          const boost::system::error_code &ec,
-          std::size_t bytes_transferred) mutable {
+      FinishFlush(std::move(buffer), zero_copy, ec, bytes_transferred);
+    });
+    return;
+  }
+
+  socket_.async_send(
+      sequence, flags,
+      [this, buffer{std::move(buffer)}, zero_copy,
+       cancelable{write_cancelable_}](const boost::system::error_code &ec,
+                                      std::size_t bytes_transferred) mutable {
         if (cancelable.canceled()) {
           return;
         }
 
-        state_machine_.WriteEnd();
+        if (!ec) {
+          ConsumeSent(&buffer, bytes_transferred, zero_copy);
+        }
 
-        if (ec) {
-          auto error = ConvertBoostError(ec);
-          NEERROR << "Write to socket failed due to " << error << ".";
+        FinishFlush(std::move(buffer), zero_copy, ec, bytes_transferred);
+      });
+}
 
-          state_machine_.Errored();
-          // report and connect cancelable should not be in use.
-          read_cancelable_.Cancel();
+void TcpSocket::ConsumeSent(utils::Buffer *buffer, size_t bytes_transferred,
+                            bool zero_copy) {
+  if (zero_copy) {
+    // Hold the memory of the sent data until the system is done with it.
+    utils::Buffer rest = buffer->Break(bytes_transferred);
+    zero_copy_writes_.push_back(
+        ZeroCopyWrite{zero_copy_next_id_++, false, std::move(*buffer)});
+    *buffer = std::move(rest);
+    WaitForZeroCopyCompletion();
+  } else {
+    MutableStats().copied_bytes += bytes_transferred;
+    buffer->ShrinkFront(bytes_transferred);
+  }
+}
 
-          handler(utils::MakeErrorResult(std::move(error)));
-          return;
-        }
+void TcpSocket::FinishFlush(utils::Buffer &&buffer, bool zero_copy,
+                            const boost::system::error_code &ec,
+                            size_t bytes_transferred) {
+  flushing_ = false;
+  writing_bytes_ = 0;
+
+  if (zero_copy && ec == boost::asio::error::no_buffer_space) {
+    NEDEBUG << "Too many zero copy writes outstanding, copy the data "
+               "instead.";
+    zero_copy_suspended_ = true;
+    write_buffer_.InsertFront(std::move(buffer));
+    Flush();
+    return;
+  }
+
+  if (ec) {
+    ReportWriteError(ec);
+    return;
+  }
+
+  NETRACE << "Successfully write " << bytes_transferred << " bytes to socket.";
+
+  if (buffer.size()) {
+    write_buffer_.InsertFront(std::move(buffer));
+  }
 
-        NETRACE << "Successfully write " << bytes_transferred
-                << " bytes to socket.";
+  CompleteWrites(bytes_transferred);
+}
+
+void TcpSocket::CompleteWrites(size_t bytes_transferred) {
+  // The socket may be released in the handlers.
+  auto cancelable = write_cancelable_;
 
-        BOOST_ASSERT(bytes_transferred == buffer.size());
+  while (!write_queue_.empty() &&
+         write_queue_.front().size <= bytes_transferred) {
+    auto write = std::move(write_queue_.front());
+    write_queue_.pop_front();
+    bytes_transferred -= write.size;
 
-        write_buffer_->clear();
+    UpdateWritable();
 
-        handler({});
+    if (!write.cancelable.canceled()) {
+      write.handler({});
+      if (cancelable.canceled()) {
         return;
-      });
-  return write_cancelable_;
+      }
+    }
+  }
+
+  if (!write_queue_.empty()) {
+    write_queue_.front().size -= bytes_transferred;
+    Flush();
+    return;
+  }
+
+  if (close_write_handler_) {
+    DoCloseWrite();
+  }
+}
+
+void TcpSocket::ReportWriteError(const boost::system::error_code &ec) {
+  auto error = ConvertBoostError(ec);
+  NEERROR << "Write to socket failed due to " << error << ".";
+
+  state_machine_.Errored();
+  // report and connect cancelable should not be in use.
+  read_cancelable_.Cancel();
+
+  // Every pending handler is reported. A handler may release the socket, so
+  // they are all moved out first.
+  auto writes = std::move(write_queue_);
+  write_queue_.clear();
+  write_buffer_ = utils::Buffer();
+  auto close_write_handler = std::move(close_write_handler_);
+  close_write_handler_ = nullptr;
+  auto close_cancelable = close_cancelable_;
+
+  for (auto &write : writes) {
+    if (!write.cancelable.canceled()) {
+      write.handler(utils::MakeErrorResult(error.Dup()));
+    }
+  }
+
+  if (close_write_handler && !close_cancelable.canceled()) {
+    close_write_handler(utils::MakeErrorResult(std::move(error)));
+  }
+}
+
+void TcpSocket::UpdateWritable() {
+  bool full = write_queue_.size() >= NEKIT_TCP_SOCKET_WRITE_QUEUE_DEPTH ||
+              bytes_in_flight() >= NEKIT_TCP_SOCKET_WRITE_QUEUE_SIZE;
+
+  if (full && state_machine_.IsWritable()) {
+    state_machine_.WriteBegin();
+  } else if (!full && state_machine_.IsWriting()) {
+    state_machine_.WriteEnd();
+  }
+}
+
+size_t TcpSocket::write_queue_depth() const { return write_queue_.size(); }
+
+size_t TcpSocket::bytes_in_flight() const {
+  return write_buffer_.size() + writing_bytes_;
+}
+
+void TcpSocket::SetCork(bool cork) {
+  cork_ = cork;
+  if (!cork_) {
+    ScheduleFlush();
+  }
 }
 
 utils::Cancelable TcpSocket::CloseWrite(EventHandler handler) {
   NEDEBUG << "Closing socket writing.";
 
+  close_cancelable_ = utils::Cancelable();
+  close_write_handler_ = handler;
+
+  state_machine_.WriteCloseBegin();
+
+  // The queued data is sent before closing.
+  if (write_queue_.empty()) {
+    DoCloseWrite();
+  }
+
+  return close_cancelable_;
+}
+
+void TcpSocket::DoCloseWrite() {
+  StartDeferredConnect();
+
   boost::system::error_code ec;
   socket_.shutdown(socket_.shutdown_send, ec);
   if (ec && ec != boost::asio::error::not_connected) {
@@ -215,12 +572,10 @@ utils::Cancelable TcpSocket::CloseWrite(EventHandler handler) {
   NEDEBUG << "Socket writing closed.";
 
   auto error = ConvertBoostError(ec);
+  auto handler = std::move(close_write_handler_);
+  close_write_handler_ = nullptr;
 
-  write_cancelable_ = utils::Cancelable();
-
-  state_machine_.WriteCloseBegin();
-
-  GetRunloop()->Post([this, handler, cancelable{write_cancelable_},
+  GetRunloop()->Post([this, handler, cancelable{close_cancelable_},
                       error{std::move(error)}]() mutable {
     if (cancelable.canceled()) {
       return;
@@ -234,10 +589,181 @@ utils::Cancelable TcpSocket::CloseWrite(EventHandler handler) {
       handler({});
     }
   });
+}
+
+void TcpSocket::StartDeferredConnect() {
+  if (fast_open_state_ != FastOpenState::Deferred) {
+    return;
+  }
+
+  NEDEBUG << "Nothing to send with SYN, connect without data.";
+
+  fast_open_state_ = FastOpenState::Sent;
+
+#if defined(__linux__)
+  // Sending nothing starts the handshake, it reports `EINPROGRESS` since the
+  // socket is not connected yet.
+  if (::send(socket_.native_handle(), nullptr, 0, MSG_NOSIGNAL) < 0 &&
+      errno != EINPROGRESS) {
+    NEDEBUG << "Failed to start deferred connection due to "
+            << std::strerror(errno) << ".";
+  }
+#endif
+}
+
+bool TcpSocket::IsSynDataAcked() {
+#if defined(__linux__)
+  struct tcp_info info;
+  return GetTcpInfo(socket_.native_handle(), &info) &&
+         (info.tcpi_options & TCPI_OPT_SYN_DATA);
+#else
+  return false;
+#endif
+}
+
+void TcpSocket::CountFastOpenAccept() {
+  if (IsSynDataAcked()) {
+    MutableStats().fast_open_accepts++;
+  }
+}
+
+bool TcpSocket::ShouldZeroCopy(size_t size) {
+#if NE_TCP_ZERO_COPY
+  if (size < NEKIT_TCP_SOCKET_ZERO_COPY_THRESHOLD || zero_copy_suspended_ ||
+      zero_copy_state_ == ZeroCopyState::Disabled) {
+    return false;
+  }
+
+  if (zero_copy_state_ == ZeroCopyState::Unknown) {
+    int enabled = 0;
+    socklen_t len = sizeof(enabled);
+    if (getsockopt(socket_.native_handle(), SOL_SOCKET, SO_ZEROCOPY, &enabled,
+                   &len) == 0 &&
+        enabled) {
+      zero_copy_state_ = ZeroCopyState::Enabled;
+    } else {
+      zero_copy_state_ = ZeroCopyState::Disabled;
+    }
+  }
+
+  return zero_copy_state_ == ZeroCopyState::Enabled;
+#else
+  (void)size;
+  return false;
+#endif
+}
+
+void TcpSocket::WaitForZeroCopyCompletion() {
+  if (zero_copy_waiting_ || zero_copy_writes_.empty()) {
+    return;
+  }
+
+  zero_copy_waiting_ = true;
+
+  // The notifications are queued in the error queue of the socket.
+  socket_.async_wait(
+      boost::asio::ip::tcp::socket::wait_error,
+      [this,
+       cancelable{zero_copy_cancelable_}](const boost::system::error_code &ec) {
+        if (cancelable.canceled()) {
+          return;
+        }
+
+        zero_copy_waiting_ = false;
+
+        // Stop waiting if the socket is woken up by an error instead, the
+        // outstanding writes are checked again after the next send.
+        if (ec ||
+            !ReapZeroCopyWrites(socket_.native_handle(), &zero_copy_writes_)) {
+          return;
+        }
+
+        if (zero_copy_writes_.empty()) {
+          zero_copy_suspended_ = false;
+        }
+
+        WaitForZeroCopyCompletion();
+      });
+}
 
-  return write_cancelable_;
+void TcpSocket::WaitForZeroCopyLinger(std::shared_ptr<ZeroCopyLinger> linger) {
+  linger->socket.async_wait(
+      boost::asio::ip::tcp::socket::wait_error,
+      [linger](const boost::system::error_code &ec) {
+        ReapZeroCopyWrites(linger->socket.native_handle(), &linger->writes);
+
+        // The socket is closed once `linger` is released.
+        if (ec || linger->writes.empty()) {
+          return;
+        }
+
+        WaitForZeroCopyLinger(linger);
+      });
+}
+
+bool TcpSocket::ReapZeroCopyWrites(int fd, std::deque<ZeroCopyWrite> *writes) {
+#if NE_TCP_ZERO_COPY
+  bool reaped = false;
+
+  while (true) {
+    char control[CMSG_SPACE(sizeof(struct sock_extended_err)) * 2];
+    struct msghdr msg {};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+      break;
+    }
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+          !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+        continue;
+      }
+
+      auto error =
+          reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(cmsg));
+      if (error->ee_errno != 0 ||
+          error->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+        continue;
+      }
+
+      reaped = true;
+
+      // The notification covers the writes in [ee_info, ee_data].
+      uint32_t from = error->ee_info, to = error->ee_data;
+      bool copied = error->ee_code & SO_EE_CODE_ZEROCOPY_COPIED;
+      for (auto &write : *writes) {
+        if (write.completed ||
+            uint32_t(write.id - from) > uint32_t(to - from)) {
+          continue;
+        }
+
+        write.completed = true;
+        if (copied) {
+          MutableStats().copied_bytes += write.buffer.size();
+        } else {
+          MutableStats().zero_copy_bytes += write.buffer.size();
+        }
+      }
+    }
+  }
+
+  while (!writes->empty() && writes->front().completed) {
+    writes->pop_front();
+  }
+
+  return reaped;
+#else
+  (void)fd;
+  (void)writes;
+  return false;
+#endif
 }
 
+const TcpSocketStats &TcpSocket::Stats() { return MutableStats(); }
+
 const data_flow::FlowStateMachine &TcpSocket::StateMachine() const {
   return state_machine_;
 }
@@ -248,6 +774,16 @@ std::shared_ptr<utils::Endpoint> TcpSocket::ConnectingTo() {
   return connect_to_;
 }
 
+void TcpSocket::SetReadReserveSize(utils::BufferReserveSize reserve_size) {
+  read_reserve_size_ = reserve_size;
+}
+
+boost::asio::ip::tcp::socket *TcpSocket::BoostSocket() {
+  // The owner may wait for the socket to be readable first.
+  StartDeferredConnect();
+  return &socket_;
+}
+
 data_flow::DataType TcpSocket::FlowDataType() const {
   return data_flow::DataType::Stream;
 }
@@ -305,6 +841,7 @@ utils::Cancelable TcpSocket::Connect(std::shared_ptr<utils::Endpoint> endpoint,
   BOOST_ASSERT(connect_to_);
 
   connector_ = std::make_unique<TcpConnector>(GetRunloop(), connect_to_);
+  connector_->SetSocketOptions(socket_options_);
 
   state_machine_.ConnectBegin();
 
@@ -318,6 +855,20 @@ utils::Cancelable TcpSocket::Connect(std::shared_ptr<utils::Endpoint> endpoint,
         if (result) {
           state_machine_.Connected();
           socket_ = std::move(*result);
+
+#if defined(__linux__)
+          // With `TCP_FASTOPEN_CONNECT` the connection is not started until
+          // the first write if there is a fast open cookie for the server.
+          struct tcp_info info;
+          if (socket_options_ && socket_options_->fast_open_enabled() &&
+              GetTcpInfo(socket_.native_handle(), &info) &&
+              info.tcpi_state == TCP_SYN_SENT) {
+            NEDEBUG << "Connection deferred to send data in SYN.";
+            fast_open_state_ = FastOpenState::Deferred;
+            MutableStats().fast_open_connects++;
+          }
+#endif
+
           handler({});
           return;
         } else {
@@ -36,10 +36,12 @@ namespace transport {
 
 Tunnel::Tunnel(
     std::unique_ptr<data_flow::LocalDataFlowInterface>&& local_data_flow,
-    rule::RuleManager* rule_manager)
+    rule::RuleManager* rule_manager, size_t memory_limit,
+    utils::MemoryBudget* parent_memory_budget)
     : session_{local_data_flow->Session()},
       rule_manager_{rule_manager},
       local_data_flow_{std::move(local_data_flow)},
+      memory_budget_{memory_limit, parent_memory_budget},
       timeout_timer_{session_->GetRunloop(), [this]() { ReleaseTunnel(); }} {
   CreateTrackId();
   auto flow = local_data_flow_.get();
@@ -51,11 +53,13 @@ Tunnel::Tunnel(
 
 Tunnel::~Tunnel() {
   open_cancelable_.Cancel();
-  local_read_cancelable_.Cancel();
-  local_write_cancelable_.Cancel();
-  remote_read_cancelable_.Cancel();
-  remote_write_cancelable_.Cancel();
+  local_forwarding_.read_cancelable.Cancel();
+  local_forwarding_.write_cancelable.Cancel();
+  remote_forwarding_.read_cancelable.Cancel();
+  remote_forwarding_.write_cancelable.Cancel();
   rule_cancelable_.Cancel();
+  memory_cancelable_.Cancel();
+  forward_cancelable_.Cancel();
 }
 
 void Tunnel::Open() {
@@ -79,6 +83,17 @@ void Tunnel::Open() {
 
 utils::Runloop* Tunnel::GetRunloop() { return session_->GetRunloop(); }
 
+const utils::MemoryBudget& Tunnel::memory_budget() const {
+  return memory_budget_;
+}
+
+void Tunnel::SetForwardWatermarks(size_t high, size_t low) {
+  BOOST_ASSERT(low <= high);
+
+  high_watermark_ = high;
+  low_watermark_ = low;
+}
+
 void Tunnel::MatchRule() {
   NEDEBUGT << "Matching rules.";
 
@@ -130,97 +145,160 @@ void Tunnel::FinishLocalNegotiation() {
 }
 
 void Tunnel::BeginForward() {
-  ForwardLocal();
-  ForwardRemote();
-}
+  if (BeginSplice()) {
+    return;
+  }
 
-void Tunnel::ForwardLocal() {
-  CheckTunnelStatus();
+  // The data read from one side is written to the other side, reserve the
+  // space it needs to encapsulate the data in place.
+  local_data_flow_->SetReadReserveSize(
+      remote_data_flow_->ChainWriteReserveSize());
+  remote_data_flow_->SetReadReserveSize(
+      local_data_flow_->ChainWriteReserveSize());
 
-  BOOST_ASSERT(local_data_flow_->StateMachine().IsReadable());
-  BOOST_ASSERT(remote_data_flow_->StateMachine().IsWritable());
+  local_forwarding_.from = local_data_flow_.get();
+  local_forwarding_.to = remote_data_flow_.get();
+  remote_forwarding_.from = remote_data_flow_.get();
+  remote_forwarding_.to = local_data_flow_.get();
 
-  NEDEBUGT << "Forward local data to remote.";
+  Forward(&local_forwarding_);
+  Forward(&remote_forwarding_);
+}
 
-  local_read_cancelable_ =
-      local_data_flow_->Read([this](utils::Result<utils::Buffer>&& buffer) {
-        ResetTimer();
+bool Tunnel::BeginSplice() {
+#if NEKIT_TUNNEL_USE_SPLICE
+  auto local_socket = SpliceRelay::FindSocket(local_data_flow_.get());
+  auto remote_socket = SpliceRelay::FindSocket(remote_data_flow_.get());
+  if (!local_socket || !remote_socket) {
+    return false;
+  }
 
-        if (!buffer) {
-          if (utils::CommonErrorCategory::IsEof(buffer.error())) {
-            // Close remote write if it is not closed yet.
-            if (remote_data_flow_->StateMachine().IsWriteClosable()) {
-              remote_write_cancelable_ =
-                  remote_data_flow_->CloseWrite([this](utils::Result<void>&&) {
-                    ResetTimer();
-                    CheckTunnelStatus();
-                  });
-              return;
-            } else {
-              CheckTunnelStatus();
-            }
-            return;
-          }
+  splice_relay_ =
+      SpliceRelay::Create(GetRunloop(), local_socket, remote_socket);
+  if (!splice_relay_) {
+    return false;
+  }
 
-          ReleaseTunnel();
-          return;
-        }
+  NEDEBUGT << "Relay data with splice.";
+
+  // The data never leaves the kernel, so it is not charged to the memory
+  // budget.
+  splice_relay_->Relay([this]() { ResetTimer(); },
+                       [this](utils::Result<void>&& result) {
+                         if (!result) {
+                           NEDEBUGT << "Splice relay failed due to "
+                                    << result.error() << ".";
+                         }
+                         ReleaseTunnel();
+                       });
+  return true;
+#else
+  return false;
+#endif
+}
 
-        remote_write_cancelable_ = remote_data_flow_->Write(
-            *std::move(buffer), [this](utils::Result<void>&& result) {
-              ResetTimer();
+void Tunnel::Forward(Forwarding* forwarding) {
+  if (forwarding->pending || forwarding->eof) {
+    return;
+  }
 
-              if (!result) {
-                LocalReportError(std::move(result).error());
-                return;
-              }
-              ForwardLocal();
-            });
-      });
-}
+  // Continue once a write completes.
+  if (forwarding->bytes_in_flight &&
+      forwarding->bytes_in_flight >= high_watermark_) {
+    forwarding->paused = true;
+    return;
+  }
+  if (!forwarding->to->StateMachine().IsWritable()) {
+    return;
+  }
 
-void Tunnel::ForwardRemote() {
-  CheckTunnelStatus();
+  BOOST_ASSERT(forwarding->from->StateMachine().IsReadable());
 
-  BOOST_ASSERT(local_data_flow_->StateMachine().IsWritable());
-  BOOST_ASSERT(remote_data_flow_->StateMachine().IsReadable());
+  forwarding->pending = true;
 
-  NEDEBUGT << "Forward remote data to local.";
+  if (!memory_budget_.Available()) {
+    NEDEBUGT << "Memory budget exhausted, pause reading.";
+    WaitForMemory([this, forwarding]() {
+      forwarding->pending = false;
+      Forward(forwarding);
+    });
+    return;
+  }
 
-  remote_read_cancelable_ =
-      remote_data_flow_->Read([this](utils::Result<utils::Buffer>&& buffer) {
+  forwarding->read_cancelable = forwarding->from->Read(
+      [this, forwarding](utils::Result<utils::Buffer>&& buffer) {
+        forwarding->pending = false;
         ResetTimer();
 
         if (!buffer) {
           if (utils::CommonErrorCategory::IsEof(buffer.error())) {
-            if (local_data_flow_->StateMachine().IsWriteClosable()) {
-              local_write_cancelable_ =
-                  local_data_flow_->CloseWrite([this](utils::Result<void>) {
-                    ResetTimer();
-                    CheckTunnelStatus();
-                  });
-            } else {
-              CheckTunnelStatus();
-            }
+            forwarding->eof = true;
+            CloseWriteIfDrained(forwarding);
             return;
           }
 
           LocalReportError(std::move(buffer).error());
           return;
         }
-        local_write_cancelable_ = local_data_flow_->Write(
-            *std::move(buffer), [this](utils::Result<void> result) {
+
+        size_t size = buffer->size();
+        forwarding->bytes_in_flight += size;
+        // Charge the chunks holding the data rather than the data itself.
+        forwarding->reservations.push_back(
+            memory_budget_.Reserve(buffer->memory_size()));
+
+        forwarding->write_cancelable = forwarding->to->Write(
+            *std::move(buffer), [this, forwarding, size,
+                                 cancelable{forward_cancelable_}](
+                                    utils::Result<void>&& result) {
+              if (cancelable.canceled()) {
+                return;
+              }
+
+              forwarding->bytes_in_flight -= size;
+              forwarding->reservations.pop_front();
               ResetTimer();
 
               if (!result) {
-                ReleaseTunnel();
+                LocalReportError(std::move(result).error());
                 return;
               }
-              ForwardRemote();
+
+              if (forwarding->eof) {
+                CloseWriteIfDrained(forwarding);
+                return;
+              }
+
+              if (forwarding->paused &&
+                  forwarding->bytes_in_flight > low_watermark_) {
+                return;
+              }
+              forwarding->paused = false;
+              Forward(forwarding);
             });
+
+        // Read more while the data is being written.
+        Forward(forwarding);
       });
 }
 
+void Tunnel::CloseWriteIfDrained(Forwarding* forwarding) {
+  if (forwarding->bytes_in_flight) {
+    return;
+  }
+
+  // Close the other side if it is not closed yet.
+  if (forwarding->to->StateMachine().IsWriteClosable()) {
+    forwarding->write_cancelable =
+        forwarding->to->CloseWrite([this](utils::Result<void>&&) {
+          ResetTimer();
+          CheckTunnelStatus();
+        });
+  } else {
+    CheckTunnelStatus();
+  }
+}
+
 void Tunnel::LocalReportError(utils::Error&&) { ReleaseTunnel(); }
 
 void Tunnel::CheckTunnelStatus() {
@@ -239,26 +317,85 @@ void Tunnel::ReleaseTunnel() {
 
 void Tunnel::ResetTimer() { timeout_timer_.Wait(TIMEOUT_INTERVAL); }
 
+void Tunnel::WaitForMemory(std::function<void()> handler) {
+  memory_budget_.Wait([this, handler, cancelable{memory_cancelable_}]() {
+    if (cancelable.canceled()) {
+      return;
+    }
+
+    // The memory is usually released in the handler of another operation,
+    // continue in a fresh stack.
+    GetRunloop()->Post([handler, cancelable]() {
+      if (cancelable.canceled()) {
+        return;
+      }
+      handler();
+    });
+  });
+}
+
 Tunnel& TunnelManager::Build(
     std::unique_ptr<data_flow::LocalDataFlowInterface>&& local_data_flow,
     rule::RuleManager* rule_manager) {
-  auto tunnel = std::make_unique<transport::Tunnel>(std::move(local_data_flow),
-                                                    rule_manager);
+  auto tunnel = new Tunnel(std::move(local_data_flow), rule_manager,
+                           tunnel_memory_limit_, memory_budget_);
   tunnel->tunnel_manager_ = this;
+  tunnel->SetForwardWatermarks(high_watermark_, low_watermark_);
 
-  auto tunnel_ptr = tunnel.get();
-
-  tunnels_[tunnel.get()] = std::move(tunnel);
+  tunnels_.push_back(*tunnel);
 
   NEDEBUG << "Created new tunnel, there are " << tunnels_.size() << " tunnels.";
-  return *tunnel_ptr;
+  return *tunnel;
 }
 
-void TunnelManager::CloseAll() { tunnels_.clear(); }
+TunnelManager::~TunnelManager() {
+  tunnels_.clear_and_dispose(std::default_delete<Tunnel>());
+}
+
+void TunnelManager::CloseAll() {
+  tunnels_.clear_and_dispose(std::default_delete<Tunnel>());
+
+  if (empty_handler_) {
+    auto handler = std::move(empty_handler_);
+    empty_handler_ = nullptr;
+    handler();
+  }
+}
+
+void TunnelManager::SetMemoryBudget(utils::MemoryBudget* memory_budget) {
+  memory_budget_ = memory_budget;
+}
+
+void TunnelManager::SetTunnelMemoryLimit(size_t limit) {
+  tunnel_memory_limit_ = limit;
+}
+
+void TunnelManager::SetForwardWatermarks(size_t high, size_t low) {
+  high_watermark_ = high;
+  low_watermark_ = low;
+}
+
+size_t TunnelManager::tunnel_count() const { return tunnels_.size(); }
+
+void TunnelManager::NotifyWhenEmpty(std::function<void()> handler) {
+  if (tunnels_.empty()) {
+    handler();
+    return;
+  }
+
+  empty_handler_ = handler;
+}
 
 void TunnelManager::NotifyClosed(Tunnel* tunnel) {
-  tunnels_.erase(tunnel);
+  tunnels_.erase_and_dispose(tunnels_.iterator_to(*tunnel),
+                             std::default_delete<Tunnel>());
   NEDEBUG << "Removed one tunnel, there are " << tunnels_.size() << " tunnels.";
+
+  if (tunnels_.empty() && empty_handler_) {
+    auto handler = std::move(empty_handler_);
+    empty_handler_ = nullptr;
+    handler();
+  }
 }
 
 }  // namespace transport
@@ -28,72 +28,280 @@
 
 #include <boost/assert.hpp>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NEKIT_BUFFER_FIND_AVX2
+#endif
+
+#include "nekit/config.h"
+
 namespace nekit {
 namespace utils {
 
-// Buf can't have size 0
-struct Buf {
-  friend class Buffer;
+namespace {
+void ReleaseChunk(BufferChunk* chunk) {
+  BOOST_ASSERT(chunk->refcount_);
+  if (!--chunk->refcount_) {
+    BufferPool::Deallocate(chunk);
+  }
+}
 
-  std::unique_ptr<uint8_t[]> data_;
+// The kernels below return the first position in `data` where `pattern` is
+// fully contained, or `Buffer::npos`.
+size_t FindScalar(const uint8_t* data, size_t size, const uint8_t* pattern,
+                  size_t len) {
+  if (size < len) {
+    return Buffer::npos;
+  }
 
-  size_t capacity_;
-  size_t offset_;
-  size_t size_;
+  const uint8_t* current = data;
+  const uint8_t* end = data + size - len + 1;
+  while (current < end) {
+    current = static_cast<const uint8_t*>(
+        std::memchr(current, pattern[0], end - current));
+    if (!current) {
+      return Buffer::npos;
+    }
+    if (current[len - 1] == pattern[len - 1] &&
+        !std::memcmp(current, pattern, len)) {
+      return current - data;
+    }
+    ++current;
+  }
+  return Buffer::npos;
+}
 
-  std::unique_ptr<Buf> next_buf_;
+inline unsigned CountTrailingZero(uint32_t mask) {
+#if defined(__GNUC__)
+  return __builtin_ctz(mask);
+#else
+  unsigned count = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    ++count;
+  }
+  return count;
+#endif
+}
 
-  Buf(size_t size)
-      : data_{std::make_unique<uint8_t[]>(size)},
-        capacity_{size},
-        offset_{0},
-        size_{size},
-        next_buf_{nullptr} {
-    BOOST_ASSERT(size);
+// Both the SIMD kernels compare the first and the last byte of the pattern
+// with a block of candidate positions at once, only the candidates matching
+// both are verified with `memcmp`.
+#if defined(__SSE2__)
+size_t FindSse2(const uint8_t* data, size_t size, const uint8_t* pattern,
+                size_t len) {
+  if (size < len) {
+    return Buffer::npos;
   }
 
-  void Append(std::unique_ptr<Buf> buf) {
-    BOOST_ASSERT(buf);
+  const __m128i first = _mm_set1_epi8(static_cast<char>(pattern[0]));
+  const __m128i last = _mm_set1_epi8(static_cast<char>(pattern[len - 1]));
+  const size_t candidates = size - len + 1;
+
+  size_t i = 0;
+  for (; i + 16 <= candidates; i += 16) {
+    const __m128i block_first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i block_last =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + len - 1));
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+    while (mask) {
+      size_t pos = i + CountTrailingZero(mask);
+      if (len <= 2 || !std::memcmp(data + pos + 1, pattern + 1, len - 2)) {
+        return pos;
+      }
+      mask &= mask - 1;
+    }
+  }
 
-    if (buf == next_buf_) {
-      return;
+  size_t found = FindScalar(data + i, size - i, pattern, len);
+  return found == Buffer::npos ? found : found + i;
+}
+#endif
+
+#if defined(NEKIT_BUFFER_FIND_AVX2)
+__attribute__((target("avx2"))) size_t FindAvx2(const uint8_t* data,
+                                                size_t size,
+                                                const uint8_t* pattern,
+                                                size_t len) {
+  if (size < len) {
+    return Buffer::npos;
+  }
+
+  const __m256i first = _mm256_set1_epi8(static_cast<char>(pattern[0]));
+  const __m256i last = _mm256_set1_epi8(static_cast<char>(pattern[len - 1]));
+  const size_t candidates = size - len + 1;
+
+  size_t i = 0;
+  for (; i + 32 <= candidates; i += 32) {
+    const __m256i block_first =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i block_last = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(data + i + len - 1));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(first, block_first),
+            _mm256_cmpeq_epi8(last, block_last))));
+    while (mask) {
+      size_t pos = i + CountTrailingZero(mask);
+      if (len <= 2 || !std::memcmp(data + pos + 1, pattern + 1, len - 2)) {
+        return pos;
+      }
+      mask &= mask - 1;
     }
+  }
+
+  size_t found = FindScalar(data + i, size - i, pattern, len);
+  return found == Buffer::npos ? found : found + i;
+}
 
-    next_buf_ = std::move(buf);
+bool HasAvx2() {
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+}
+#endif
+
+size_t FindInChunk(const uint8_t* data, size_t size, const uint8_t* pattern,
+                   size_t len) {
+#if defined(NEKIT_BUFFER_FIND_AVX2)
+  if (size >= 32 + len && HasAvx2()) {
+    return FindAvx2(data, size, pattern, len);
   }
+#endif
+#if defined(__SSE2__)
+  return FindSse2(data, size, pattern, len);
+#else
+  return FindScalar(data, size, pattern, len);
+#endif
+}
 
-  std::unique_ptr<Buf> Break(size_t pos) {
-    BOOST_ASSERT(pos);
-    BOOST_ASSERT(pos <= size_);
+// Whether `pattern` is at `offset` of `buf`, the data can continue into the
+// following `Buf`s.
+bool MatchAcross(const Buf* buf, size_t offset, const uint8_t* pattern,
+                 size_t len) {
+  while (len) {
+    if (!buf) {
+      return false;
+    }
 
-    if (pos == size_) {
-      auto temp = std::move(next_buf_);
-      next_buf_ = nullptr;
-      return temp;
+    size_t compare = std::min(len, buf->size_ - offset);
+    if (std::memcmp(buf->data() + buf->offset_ + offset, pattern, compare)) {
+      return false;
     }
+    pattern += compare;
+    len -= compare;
+    buf = buf->next_buf_.get();
+    offset = 0;
+  }
+  return true;
+}
+}  // namespace
+
+constexpr size_t Buffer::npos;
+
+Buf::Buf(size_t size)
+    : chunk_{BufferPool::AllocateFromCurrent(size)},
+      begin_{0},
+      capacity_{chunk_->capacity_},
+      offset_{0},
+      size_{size},
+      shared_{false},
+      next_buf_{nullptr},
+      prev_buf_{nullptr} {
+  BOOST_ASSERT(size);
+  chunk_->refcount_ = 1;
+}
 
-    auto result = std::make_unique<Buf>(size_ - pos);
-    std::memcpy(result->data_.get(), data_.get() + offset_ + pos, size_ - pos);
-    result->next_buf_ = std::move(next_buf_);
-    next_buf_ = nullptr;
-    size_ = pos;
+Buf::Buf(BufferChunk* chunk, size_t begin, size_t size, bool shared)
+    : chunk_{chunk},
+      begin_{begin},
+      capacity_{size},
+      offset_{0},
+      size_{size},
+      shared_{shared},
+      next_buf_{nullptr},
+      prev_buf_{nullptr} {
+  BOOST_ASSERT(size);
+  chunk_->refcount_++;
+}
+
+Buf::~Buf() { ReleaseChunk(chunk_); }
+
+void* Buf::operator new(size_t size) {
+  return BufferPool::AllocateFromCurrent(size)->data();
+}
 
-    return result;
+void Buf::operator delete(void* pointer) {
+  BufferPool::Deallocate(BufferChunk::FromData(pointer));
+}
+
+std::unique_ptr<Buf> Buf::Break(size_t pos) {
+  BOOST_ASSERT(pos);
+  BOOST_ASSERT(pos <= size_);
+
+  if (pos == size_) {
+    return std::move(next_buf_);
   }
-};
+
+  auto result = std::make_unique<Buf>(chunk_, begin_ + offset_ + pos,
+                                      size_ - pos, shared_);
+  // The tail room goes with the second half.
+  result->capacity_ = capacity_ - offset_ - pos;
+  result->SetNext(std::move(next_buf_));
+  capacity_ = offset_ + pos;
+  size_ = pos;
+
+  return result;
+}
+
+void Buf::CopyOnWrite() {
+  shared_ = false;
+  if (chunk_->refcount_ == 1) {
+    return;
+  }
+
+  auto chunk = BufferPool::AllocateFromCurrent(capacity_);
+  chunk->refcount_ = 1;
+  std::memcpy(chunk->data() + offset_, data() + offset_, size_);
+  ReleaseChunk(chunk_);
+
+  chunk_ = chunk;
+  begin_ = 0;
+  capacity_ = chunk->capacity_;
+}
 
 Buffer::Buffer(size_t size) {
   if (size) {
     head_ = std::make_unique<Buf>(size);
     tail_ = head_.get();
+    chunk_count_ = 1;
   } else {
     head_ = nullptr;
     tail_ = nullptr;
+    chunk_count_ = 0;
   }
 
   size_ = size;
 }
 
+Buffer::Buffer(size_t size, const BufferReserveSize& reserve_size)
+    : Buffer(0) {
+  if (size) {
+    head_ = std::make_unique<Buf>(reserve_size.prefix() + size +
+                                  reserve_size.suffix());
+    head_->offset_ = reserve_size.prefix();
+    head_->size_ = size;
+    tail_ = head_.get();
+    size_ = size;
+    chunk_count_ = 1;
+  }
+}
+
 Buffer::Buffer() : Buffer(0) {}
 
 Buffer::Buffer(Buffer&& buffer) { *this = std::move(buffer); }
@@ -106,8 +314,9 @@ Buffer& Buffer::operator=(Buffer&& buffer) {
   head_ = std::move(buffer.head_);
   tail_ = buffer.tail_;
   size_ = buffer.size_;
-  buffer.tail_ = nullptr;
-  buffer.size_ = 0;
+  chunk_count_ = buffer.chunk_count_;
+  DropCache();
+  buffer.Clear();
   return *this;
 }
 
@@ -118,27 +327,40 @@ Buffer::operator bool() const { return size_ != 0; }
 uint8_t& Buffer::operator[](size_t index) {
   BOOST_ASSERT(index < size());
 
-  auto current = head_.get();
-
-  while (index >= current->size_) {
-    index -= current->size_;
-    current = current->next_buf_.get();
-  }
-
-  return *(current->data_.get() + index);
+  auto location = Locate(index);
+  location.first->MakeWritable();
+  return *(location.first->data() + location.first->offset_ +
+           location.second);
 }
 
 const uint8_t& Buffer::operator[](size_t index) const {
   BOOST_ASSERT(index < size());
 
-  auto current = head_.get();
+  auto location = Locate(index);
+  return *(location.first->data() + location.first->offset_ +
+           location.second);
+}
 
-  while (index >= current->size_) {
-    index -= current->size_;
-    current = current->next_buf_.get();
+Buffer::Cursor Buffer::CursorAt(size_t pos) {
+  BOOST_ASSERT(pos <= size());
+
+  if (pos == size()) {
+    return Cursor(nullptr, 0, pos);
   }
 
-  return *(current->data_.get() + index);
+  auto location = Locate(pos);
+  return Cursor(location.first, location.second, pos);
+}
+
+Buffer::ConstCursor Buffer::CursorAt(size_t pos) const {
+  BOOST_ASSERT(pos <= size());
+
+  if (pos == size()) {
+    return ConstCursor(nullptr, 0, pos);
+  }
+
+  auto location = Locate(pos);
+  return ConstCursor(location.first, location.second, pos);
 }
 
 void Buffer::Insert(nekit::utils::Buffer&& buffer, size_t pos) {
@@ -156,13 +378,9 @@ void Buffer::Insert(nekit::utils::Buffer&& buffer, size_t pos) {
     return InsertFront(std::move(buffer));
   }
 
-  Buf* current = head_.get();
-  while (pos > current->size_) {
-    pos -= current->size_;
-    current = current->next_buf_.get();
-  }
-
-  InsertBufAt(current, std::move(buffer), pos);
+  // Insert at the end of the `Buf` containing the previous byte.
+  auto location = Locate(pos - 1);
+  InsertBufAt(location.first, std::move(buffer), location.second + 1);
 }
 
 void Buffer::Insert(size_t skip, size_t len) {
@@ -180,11 +398,9 @@ void Buffer::Insert(size_t skip, size_t len) {
     return InsertFront(len);
   }
 
-  Buf* current = head_.get();
-  while (skip > current->size_) {
-    skip -= current->size_;
-    current = current->next_buf_.get();
-  }
+  auto location = Locate(skip - 1);
+  Buf* current = location.first;
+  skip = location.second + 1;
 
   if (skip == current->size_) {
     // We are at the end of one `Buf` and want to append to this `Buf`. Let's
@@ -193,6 +409,7 @@ void Buffer::Insert(size_t skip, size_t len) {
     if (remain >= len ||
         (current->next_buf_ && remain + current->next_buf_->offset_ >= len)) {
       size_ += len;
+      DropCache();
 
       current->size_ += std::min(len, remain);
       len -= std::min(len, remain);
@@ -214,13 +431,17 @@ void Buffer::InsertFront(nekit::utils::Buffer&& buffer) {
 
   auto prev_head = std::move(head_);
   head_ = std::move(buffer.head_);
-  buffer.tail_->next_buf_ = std::move(prev_head);
+  buffer.tail_->SetNext(std::move(prev_head));
 
   if (!tail_) {
     tail_ = buffer.tail_;
   }
 
   size_ += buffer.size();
+  chunk_count_ += buffer.chunk_count_;
+  DropCache();
+  buffer.Clear();
+  MaybeCompact();
 }
 
 void Buffer::InsertFront(size_t size) {
@@ -228,6 +449,7 @@ void Buffer::InsertFront(size_t size) {
     head_->offset_ -= size;
     head_->size_ += size;
     size_ += size;
+    DropCache();
     return;
   }
 
@@ -240,17 +462,21 @@ void Buffer::InsertBack(Buffer&& buffer) {
   }
 
   if (head_) {
-    tail_->next_buf_ = std::move(buffer.head_);
-    tail_ = buffer.tail_;
+    tail_->SetNext(std::move(buffer.head_));
   } else {
     head_ = std::move(buffer.head_);
-    tail_ = buffer.tail_;
   }
+  tail_ = buffer.tail_;
 
   size_ += buffer.size();
+  chunk_count_ += buffer.chunk_count_;
+  DropCache();
+  buffer.Clear();
+  MaybeCompact();
 }
 
 void Buffer::InsertBack(size_t size) {
+  // Growing the tail doesn't move any data, the cache is still valid.
   if (tail_ && tail_->capacity_ - tail_->offset_ - tail_->size_ >= size) {
     tail_->size_ += size;
     size_ += size;
@@ -265,12 +491,12 @@ void Buffer::Shrink(size_t skip, size_t len) {
   BOOST_ASSERT(len <= size());
   BOOST_ASSERT(skip + len <= size());
 
-  Buf *current = head_.get(), *prev = nullptr;
-  while (skip >= current->size_) {
-    skip -= current->size_;
-    prev = current;
-    current = current->next_buf_.get();
-  }
+  auto location = Locate(skip);
+  Buf* current = location.first;
+  Buf* prev = current->prev_buf_;
+  skip = location.second;
+
+  DropCache();
 
   if (skip) {
     size_t buf_remain = current->size_ - skip;
@@ -281,8 +507,9 @@ void Buffer::Shrink(size_t skip, size_t len) {
       prev = current;
       current = current->next_buf_.get();
     } else {
-      std::memmove(current->data_.get() + current->offset_ + skip,
-                   current->data_.get() + current->offset_ + skip + len,
+      current->MakeWritable();
+      std::memmove(current->data() + current->offset_ + skip,
+                   current->data() + current->offset_ + skip + len,
                    current->size_ - skip - len);
       current->size_ -= len;
       size_ -= len;
@@ -301,12 +528,16 @@ void Buffer::Shrink(size_t skip, size_t len) {
     }
 
     len -= remove_length;
+    chunk_count_--;
 
     if (!prev) {
       head_ = std::move(current->next_buf_);
+      if (head_) {
+        head_->prev_buf_ = nullptr;
+      }
       current = head_.get();
     } else {
-      prev->next_buf_ = std::move(current->next_buf_);
+      prev->SetNext(std::move(current->next_buf_));
       current = prev->next_buf_.get();
     }
   }
@@ -319,8 +550,29 @@ void Buffer::Shrink(size_t skip, size_t len) {
 void Buffer::ShrinkFront(size_t size) { Shrink(0, size); }
 
 void Buffer::ShrinkBack(size_t size) {
-  // It can be optimized if the Buf is a double linked list.
-  Shrink(this->size() - size, size);
+  BOOST_ASSERT(size <= this->size());
+
+  DropCache();
+
+  while (size) {
+    auto remove_length = std::min(size, tail_->size_);
+    tail_->size_ -= remove_length;
+    size_ -= remove_length;
+    size -= remove_length;
+
+    if (tail_->size_) {
+      return;
+    }
+
+    chunk_count_--;
+    auto prev = tail_->prev_buf_;
+    if (prev) {
+      prev->next_buf_ = nullptr;
+    } else {
+      head_ = nullptr;
+    }
+    tail_ = prev;
+  }
 }
 
 void Buffer::GetData(size_t skip, size_t len, void* target) const {
@@ -328,18 +580,19 @@ void Buffer::GetData(size_t skip, size_t len, void* target) const {
   BOOST_ASSERT(len <= size());
   BOOST_ASSERT(skip + len <= size());
 
-  auto current = head_.get();
-
-  while (skip >= current->size_) {
-    skip -= current->size_;
-    current = current->next_buf_.get();
+  if (!len) {
+    return;
   }
 
+  auto location = Locate(skip);
+  auto current = location.first;
+  skip = location.second;
+
   while (len) {
     BOOST_ASSERT(current);
 
     size_t copy_len = std::min(len, current->size_ - skip);
-    std::memcpy(target, current->data_.get() + current->offset_ + skip,
+    std::memcpy(target, current->data() + current->offset_ + skip,
                 copy_len);
     len -= copy_len;
     current = current->next_buf_.get();
@@ -358,23 +611,24 @@ void Buffer::GetData(size_t skip, size_t len, nekit::utils::Buffer* target,
   BOOST_ASSERT(len <= target->size());
   BOOST_ASSERT(offset + len <= target->size());
 
-  auto tcurrent = target->head_.get();
-  while (offset >= tcurrent->size_) {
-    offset -= tcurrent->size_;
-    tcurrent = tcurrent->next_buf_.get();
+  if (!len) {
+    return;
   }
 
-  auto scurrent = head_.get();
-  while (skip >= scurrent->size_) {
-    skip -= scurrent->size_;
-    scurrent = scurrent->next_buf_.get();
-  }
+  auto tlocation = target->Locate(offset);
+  auto tcurrent = tlocation.first;
+  offset = tlocation.second;
+
+  auto slocation = Locate(skip);
+  auto scurrent = slocation.first;
+  skip = slocation.second;
 
   while (len) {
     size_t copy_len = std::min(scurrent->size_ - skip,
                                std::min(len, tcurrent->size_ - offset));
-    std::memcpy(tcurrent->data_.get() + tcurrent->offset_ + offset,
-                scurrent->data_.get() + scurrent->offset_ + skip, copy_len);
+    tcurrent->MakeWritable();
+    std::memcpy(tcurrent->data() + tcurrent->offset_ + offset,
+                scurrent->data() + scurrent->offset_ + skip, copy_len);
 
     skip += copy_len;
     offset += copy_len;
@@ -396,18 +650,16 @@ void Buffer::SetData(size_t skip, size_t len, const void* source) {
   BOOST_ASSERT(len <= size());
   BOOST_ASSERT(skip + len <= size());
 
-  auto current = head_.get();
-
-  while (skip >= current->size_) {
-    skip -= current->size_;
-    current = current->next_buf_.get();
-  }
+  auto location = Locate(skip);
+  auto current = location.first;
+  skip = location.second;
 
   while (len) {
     BOOST_ASSERT(current);
 
     size_t copy_len = std::min(len, current->size_ - skip);
-    std::memcpy(current->data_.get() + current->offset_ + skip, source,
+    current->MakeWritable();
+    std::memcpy(current->data() + current->offset_ + skip, source,
                 copy_len);
     len -= copy_len;
     current = current->next_buf_.get();
@@ -422,113 +674,345 @@ void Buffer::SetData(size_t skip, size_t len,
 }
 
 Buffer Buffer::Break(size_t skip) {
-  Buf* current = head_.get();
+  BOOST_ASSERT(skip <= size());
 
-  size_t rs = skip;
-  while (rs > current->size_) {
-    rs -= current->size_;
-    current = current->next_buf_.get();
+  if (!skip) {
+    return std::move(*this);
   }
 
-  std::unique_ptr<Buf> buf;
-  if (rs == current->size_) {
-    buf = std::move(current->next_buf_);
-  } else {
-    buf = current->Break(rs);
+  if (skip == size()) {
+    return Buffer();
+  }
+
+  auto location = Locate(skip - 1);
+  Buf* current = location.first;
+  size_t rs = location.second + 1;
+
+  DropCache();
+
+  if (rs != current->size_) {
+    chunk_count_++;
   }
 
   Buffer b;
-  b.head_ = std::move(buf);
+  b.head_ = current->Break(rs);
+  b.head_->prev_buf_ = nullptr;
+  b.tail_ = current == tail_ ? b.head_.get() : tail_;
   b.size_ = size_ - skip;
-  b.ResetTail();
+  for (Buf* buf = b.head_.get(); buf; buf = buf->next_buf_.get()) {
+    b.chunk_count_++;
+  }
 
   size_ = skip;
-  ResetTail();
+  tail_ = current;
+  chunk_count_ -= b.chunk_count_;
 
   return b;
 }
 
-void Buffer::WalkInternalChunk(
-    const std::function<bool(void*, size_t, void*)>& walker, size_t from,
-    void* context) {
-  BOOST_ASSERT(from <= size());
+Buffer Buffer::Share(size_t skip, size_t len) const {
+  BOOST_ASSERT(skip <= size());
+  BOOST_ASSERT(len <= size());
+  BOOST_ASSERT(skip + len <= size());
 
-  if (from == size()) {
-    return;
+  Buffer b;
+  if (!len) {
+    return b;
   }
 
-  Buf* current = head_.get();
+  auto location = Locate(skip);
+  Buf* current = location.first;
+  skip = location.second;
 
-  while (from >= current->size_) {
-    from -= current->size_;
-    current = current->next_buf_.get();
-  }
+  while (len) {
+    BOOST_ASSERT(current);
 
-  while (current) {
-    if (!walker(current->data_.get() + current->offset_ + from,
-                current->size_ - from, context)) {
-      return;
+    size_t share_len = std::min(len, current->size_ - skip);
+    current->shared_ = true;
+    auto buf = std::make_unique<Buf>(
+        current->chunk_, current->begin_ + current->offset_ + skip, share_len,
+        true);
+
+    auto buf_ptr = buf.get();
+    if (b.tail_) {
+      b.tail_->SetNext(std::move(buf));
+    } else {
+      b.head_ = std::move(buf);
     }
-    from = 0;
+    b.tail_ = buf_ptr;
+
+    b.size_ += share_len;
+    b.chunk_count_++;
+    len -= share_len;
     current = current->next_buf_.get();
+    skip = 0;
   }
+
+  return b;
+}
+
+void Buffer::WalkInternalChunk(
+    const std::function<bool(void*, size_t, void*)>& walker, size_t from,
+    void* context) {
+  ForEachChunk(
+      [&walker, context](void* data, size_t len) {
+        return walker(data, len, context);
+      },
+      from);
 }
 
 void Buffer::WalkInternalChunk(
     const std::function<bool(const void*, size_t, void*)>& walker, size_t from,
     void* context) const {
+  ForEachChunk(
+      [&walker, context](const void* data, size_t len) {
+        return walker(data, len, context);
+      },
+      from);
+}
+
+size_t Buffer::FindLocation(const void* pointer) {
+  size_t offset = 0;
+  static_cast<const Buffer*>(this)->ForEachChunk(
+      [&offset, pointer](const uint8_t* data, size_t len) {
+        if (pointer >= data && pointer < data + len) {
+          offset += (static_cast<const uint8_t*>(pointer) - data);
+          return false;
+        }
+
+        offset += len;
+        return true;
+      });
+
+  return offset;
+}
+
+size_t Buffer::Find(const void* pattern, size_t len, size_t from) const {
+  BOOST_ASSERT(len);
   BOOST_ASSERT(from <= size());
 
-  if (from == size()) {
-    return;
+  if (size() - from < len) {
+    return npos;
   }
 
-  Buf* current = head_.get();
+  const uint8_t* target = static_cast<const uint8_t*>(pattern);
+  auto location = Locate(from);
+  size_t skip = location.second;
+  size_t pos = from;
+  for (const Buf* current = location.first; current;
+       current = current->next_buf_.get()) {
+    const uint8_t* data = current->data() + current->offset_ + skip;
+    size_t chunk_size = current->size_ - skip;
+
+    size_t found = FindInChunk(data, chunk_size, target, len);
+    if (found != npos) {
+      return pos + found;
+    }
 
-  while (from >= current->size_) {
-    from -= current->size_;
-    current = current->next_buf_.get();
+    // The occurrences starting in the last `len - 1` bytes continue into
+    // the following chunks.
+    for (size_t i = chunk_size > len - 1 ? chunk_size - (len - 1) : 0;
+         i < chunk_size; ++i) {
+      if (data[i] == target[0] &&
+          MatchAcross(current, skip + i, target, len)) {
+        return pos + i;
+      }
+    }
+
+    pos += chunk_size;
+    skip = 0;
+    if (size() - pos < len) {
+      return npos;
+    }
   }
+  return npos;
+}
+
+size_t Buffer::size() const { return size_; }
 
+size_t Buffer::memory_size() const {
+  size_t memory_size = 0;
+  const Buf* current = head_.get();
   while (current) {
-    if (!walker(current->data_.get() + current->offset_ + from,
-                current->size_ - from, context)) {
-      return;
+    // Count the adjacent windows of the chunk, the windows separated by other
+    // chunks are treated as shared, which may only undercount.
+    auto chunk = current->chunk_;
+    uint32_t views = 0;
+    for (; current && current->chunk_ == chunk;
+         current = current->next_buf_.get()) {
+      views++;
+    }
+
+    if (views == chunk->refcount_) {
+      memory_size += chunk->capacity_;
     }
-    from = 0;
-    current = current->next_buf_.get();
   }
+  return memory_size;
 }
 
-size_t Buffer::FindLocation(const void* pointer) {
-  size_t offset = 0;
-  WalkInternalChunk(
-      [&offset, pointer](const void* data, size_t len, void* context) {
-        (void)context;
+size_t Buffer::chunk_count() const { return chunk_count_; }
 
-        const uint8_t* data__ = static_cast<const uint8_t*>(data);
+void Buffer::EnableCompaction(size_t max_chunk_count) {
+  BOOST_ASSERT(max_chunk_count);
 
-        if (pointer >= data__ && pointer < data__ + len) {
-          offset += (static_cast<const uint8_t*>(pointer) - data__);
-          return false;
-        }
+  compaction_threshold_ = max_chunk_count;
+  compaction_trigger_ = max_chunk_count;
+  MaybeCompact();
+}
 
-        offset += len;
-        return true;
-      },
-      0, nullptr);
+void Buffer::DisableCompaction() { compaction_threshold_ = 0; }
 
-  return offset;
+void Buffer::Compact() {
+  Buf* current = head_.get();
+  while (current) {
+    // Find a run of small chunks starting from `current`.
+    size_t run_size = 0, run_count = 0;
+    Buf* end = current;
+    while (end && end->size_ < NEKIT_BUFFER_COMPACTION_CHUNK_SIZE &&
+           run_size + end->size_ <= NEKIT_BUFFER_POOL_MAX_CHUNK_SIZE) {
+      run_size += end->size_;
+      run_count++;
+      end = end->next_buf_.get();
+    }
+
+    if (run_count < 2) {
+      current = end == current ? current->next_buf_.get() : end;
+      continue;
+    }
+
+    auto buf = std::make_unique<Buf>(run_size);
+    size_t offset = 0;
+    for (Buf* source = current; source != end;
+         source = source->next_buf_.get()) {
+      std::memcpy(buf->data() + offset, source->data() + source->offset_,
+                  source->size_);
+      offset += source->size_;
+    }
+
+    // Detach the run and put the new chunk in place of it.
+    Buf* prev = current->prev_buf_;
+    Buf* last = end ? end->prev_buf_ : tail_;
+    auto buf_ptr = buf.get();
+    buf->SetNext(std::move(last->next_buf_));
+    if (prev) {
+      prev->SetNext(std::move(buf));
+    } else {
+      head_ = std::move(buf);
+    }
+    if (!end) {
+      tail_ = buf_ptr;
+    }
+
+    chunk_count_ -= run_count - 1;
+    current = end;
+  }
+
+  DropCache();
 }
 
-size_t Buffer::size() const { return size_; }
+std::pair<Buf*, size_t> Buffer::Locate(size_t pos) const {
+  BOOST_ASSERT(pos < size());
+
+  size_t tail_pos = size_ - tail_->size_;
+  if (pos >= tail_pos) {
+    return {tail_, pos - tail_pos};
+  }
+
+  if (!index_.empty()) {
+    auto iter = std::upper_bound(
+        index_.begin(), index_.end(), pos,
+        [](size_t pos, const std::pair<size_t, Buf*>& entry) {
+          return pos < entry.first;
+        });
+    --iter;
+    return {iter->second, pos - iter->first};
+  }
+
+  Buf* current = head_.get();
+  size_t current_pos = 0;
+  if (hint_buf_) {
+    if (pos >= hint_pos_) {
+      current = hint_buf_;
+      current_pos = hint_pos_;
+    } else if (hint_pos_ - pos < pos) {
+      current = hint_buf_;
+      current_pos = hint_pos_;
+      while (pos < current_pos) {
+        current = current->prev_buf_;
+        current_pos -= current->size_;
+      }
+    }
+  }
+
+  size_t step = 0;
+  while (pos >= current_pos + current->size_) {
+    current_pos += current->size_;
+    current = current->next_buf_.get();
+    step++;
+  }
+
+  if (step > NEKIT_BUFFER_INDEX_THRESHOLD) {
+    BuildIndex();
+  } else {
+    hint_buf_ = current;
+    hint_pos_ = current_pos;
+  }
+
+  return {current, pos - current_pos};
+}
+
+void Buffer::BuildIndex() const {
+  size_t pos = 0;
+  for (Buf* current = head_.get(); current;
+       current = current->next_buf_.get()) {
+    index_.emplace_back(pos, current);
+    pos += current->size_;
+  }
+}
+
+void Buffer::DropCache() const {
+  hint_buf_ = nullptr;
+  index_.clear();
+}
+
+void Buffer::Clear() {
+  head_ = nullptr;
+  tail_ = nullptr;
+  size_ = 0;
+  chunk_count_ = 0;
+  DropCache();
+}
+
+void Buffer::MaybeCompact() {
+  if (!compaction_threshold_) {
+    return;
+  }
+
+  if (chunk_count_ <= compaction_threshold_) {
+    compaction_trigger_ = compaction_threshold_;
+    return;
+  }
+
+  if (chunk_count_ <= compaction_trigger_) {
+    return;
+  }
+
+  Compact();
+  // Don't try again until the chain doubles if most of the chunks are too
+  // large to be coalesced.
+  compaction_trigger_ = std::max(compaction_threshold_, 2 * chunk_count_);
+}
 
 // pos may be the size of buf
 void Buffer::InsertBufAt(Buf* buf, Buffer&& buffer, size_t pos) {
+  if (pos != buf->size_) {
+    chunk_count_++;
+  }
+
   auto new_buf = buf->Break(pos);
   auto new_buf_ptr = new_buf.get();
-  buf->next_buf_ = std::move(buffer.head_);
-  buffer.tail_->next_buf_ = std::move(new_buf);
+  buf->SetNext(std::move(buffer.head_));
+  buffer.tail_->SetNext(std::move(new_buf));
 
   if (buf == tail_) {
     if (new_buf_ptr) {
@@ -538,14 +1022,10 @@ void Buffer::InsertBufAt(Buf* buf, Buffer&& buffer, size_t pos) {
     }
   }
   size_ += buffer.size();
-}
-
-void Buffer::ResetTail() {
-  auto current = head_.get();
-  while (current->next_buf_) {
-    current = current->next_buf_.get();
-  }
-  tail_ = current;
+  chunk_count_ += buffer.chunk_count_;
+  DropCache();
+  buffer.Clear();
+  MaybeCompact();
 }
 }  // namespace utils
 }  // namespace nekit
@@ -0,0 +1,276 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "nekit/utils/buffer_pool.h"
+
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "nekit/config.h"
+
+namespace nekit {
+namespace utils {
+
+namespace {
+constexpr std::uint32_t SizeClassCount() {
+  std::uint32_t count = 1;
+  for (std::size_t size = NEKIT_BUFFER_POOL_MIN_CHUNK_SIZE;
+       size < NEKIT_BUFFER_POOL_MAX_CHUNK_SIZE; size <<= 1) {
+    count++;
+  }
+  return count;
+}
+
+constexpr std::uint32_t kSizeClassCount = SizeClassCount();
+// Chunks larger than the largest size class.
+constexpr std::uint32_t kLargeSizeClass = kSizeClassCount;
+// Chunks not allocated from a pool.
+constexpr std::uint32_t kHeapSizeClass = kSizeClassCount + 1;
+
+std::uint32_t SizeClassOf(std::size_t size) {
+  std::uint32_t size_class = 0;
+  std::size_t class_size = NEKIT_BUFFER_POOL_MIN_CHUNK_SIZE;
+  while (class_size < size) {
+    if (++size_class == kSizeClassCount) {
+      return kLargeSizeClass;
+    }
+    class_size <<= 1;
+  }
+  return size_class;
+}
+
+std::size_t SizeOfClass(std::uint32_t size_class) {
+  return static_cast<std::size_t>(NEKIT_BUFFER_POOL_MIN_CHUNK_SIZE)
+         << size_class;
+}
+
+BufferChunk* AllocateHeapChunk(std::size_t size, std::uint32_t size_class) {
+  auto chunk = static_cast<BufferChunk*>(
+      ::operator new(sizeof(BufferChunk) + std::max<std::size_t>(size, 1)));
+  chunk->arena_ = nullptr;
+  chunk->capacity_ = size;
+  chunk->size_class_ = size_class;
+  return chunk;
+}
+
+thread_local BufferPool* current_pool = nullptr;
+}  // namespace
+
+struct BufferPoolArena {
+  struct Slab {
+    void* memory;
+    std::size_t size;
+    bool mapped;
+  };
+
+  explicit BufferPoolArena(bool use_huge_page)
+      : use_huge_page_{use_huge_page} {
+    std::fill(std::begin(free_lists_), std::end(free_lists_), nullptr);
+    std::fill(std::begin(slab_cursors_), std::end(slab_cursors_), nullptr);
+    std::fill(std::begin(slab_ends_), std::end(slab_ends_), nullptr);
+  }
+
+  ~BufferPoolArena() {
+    BOOST_ASSERT(!outstanding_);
+
+    for (auto& slab : slabs_) {
+#if defined(__linux__)
+      if (slab.mapped) {
+        munmap(slab.memory, slab.size);
+        continue;
+      }
+#endif
+      ::operator delete(slab.memory);
+    }
+  }
+
+  BufferChunk* Allocate(std::size_t size) {
+    auto size_class = SizeClassOf(size);
+
+    BufferChunk* chunk;
+    if (size_class == kLargeSizeClass) {
+      chunk = AllocateHeapChunk(size, kLargeSizeClass);
+      statistics_.miss_count++;
+      statistics_.resident_bytes += size;
+    } else {
+      chunk = free_lists_[size_class];
+      if (chunk) {
+        free_lists_[size_class] = NextFree(chunk);
+        statistics_.hit_count++;
+      } else {
+        chunk = Carve(size_class);
+        statistics_.miss_count++;
+      }
+      chunk->capacity_ = SizeOfClass(size_class);
+      chunk->size_class_ = size_class;
+    }
+
+    chunk->arena_ = this;
+    statistics_.allocated_bytes += chunk->capacity_;
+    outstanding_++;
+    return chunk;
+  }
+
+  // Return true if the arena should be released.
+  bool Deallocate(BufferChunk* chunk) {
+    BOOST_ASSERT(outstanding_);
+
+    statistics_.allocated_bytes -= chunk->capacity_;
+    outstanding_--;
+
+    if (chunk->size_class_ == kLargeSizeClass) {
+      statistics_.resident_bytes -= chunk->capacity_;
+      ::operator delete(chunk);
+    } else {
+      NextFree(chunk) = free_lists_[chunk->size_class_];
+      free_lists_[chunk->size_class_] = chunk;
+    }
+
+    return orphaned_ && !outstanding_;
+  }
+
+  BufferChunk* Carve(std::uint32_t size_class) {
+    std::size_t stride = sizeof(BufferChunk) + SizeOfClass(size_class);
+
+    if (!slab_cursors_[size_class] ||
+        static_cast<std::size_t>(slab_ends_[size_class] -
+                                 slab_cursors_[size_class]) < stride) {
+      auto slab = AllocateSlab(stride);
+      slab_cursors_[size_class] = static_cast<std::uint8_t*>(slab.memory);
+      slab_ends_[size_class] = slab_cursors_[size_class] + slab.size;
+    }
+
+    auto chunk = reinterpret_cast<BufferChunk*>(slab_cursors_[size_class]);
+    slab_cursors_[size_class] += stride;
+    return chunk;
+  }
+
+  Slab AllocateSlab(std::size_t min_size) {
+    Slab slab{nullptr, 0, false};
+
+#if defined(__linux__)
+    if (use_huge_page_) {
+      std::size_t huge_page_size = NEKIT_BUFFER_POOL_HUGE_PAGE_SLAB_SIZE;
+      slab.size = (min_size + huge_page_size - 1) / huge_page_size *
+                  huge_page_size;
+      slab.memory = mmap(nullptr, slab.size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (slab.memory != MAP_FAILED) {
+#if defined(MADV_HUGEPAGE)
+        // This is only a hint, the kernel may still back the slab with normal
+        // pages.
+        madvise(slab.memory, slab.size, MADV_HUGEPAGE);
+#endif
+        slab.mapped = true;
+      } else {
+        slab.memory = nullptr;
+      }
+    }
+#endif
+
+    if (!slab.memory) {
+      slab.size = std::max<std::size_t>(NEKIT_BUFFER_POOL_SLAB_SIZE, min_size);
+      slab.memory = ::operator new(slab.size);
+    }
+
+    slabs_.push_back(slab);
+    statistics_.resident_bytes += slab.size;
+    return slab;
+  }
+
+  static BufferChunk*& NextFree(BufferChunk* chunk) {
+    return *reinterpret_cast<BufferChunk**>(chunk->data());
+  }
+
+  bool use_huge_page_;
+  bool orphaned_{false};
+  std::size_t outstanding_{0};
+
+  BufferChunk* free_lists_[kSizeClassCount];
+  std::uint8_t* slab_cursors_[kSizeClassCount];
+  std::uint8_t* slab_ends_[kSizeClassCount];
+  std::vector<Slab> slabs_;
+
+  BufferPool::Statistics statistics_;
+};
+
+BufferPool::Scope::Scope(BufferPool* pool) : previous_{current_pool} {
+  current_pool = pool;
+}
+
+BufferPool::Scope::~Scope() { current_pool = previous_; }
+
+BufferPool::BufferPool(bool use_huge_page)
+    : arena_{new BufferPoolArena(use_huge_page)} {}
+
+BufferPool::~BufferPool() {
+  BOOST_ASSERT(current_pool != this);
+
+  // Chunks still in use will release the arena when they are returned.
+  if (arena_->outstanding_) {
+    arena_->orphaned_ = true;
+  } else {
+    delete arena_;
+  }
+}
+
+BufferChunk* BufferPool::Allocate(std::size_t size) {
+  return arena_->Allocate(size);
+}
+
+BufferPool::Statistics BufferPool::GetStatistics() const {
+  return arena_->statistics_;
+}
+
+void BufferPool::Deallocate(BufferChunk* chunk) {
+  if (!chunk->arena_) {
+    BOOST_ASSERT(chunk->size_class_ == kHeapSizeClass);
+    ::operator delete(chunk);
+    return;
+  }
+
+  auto arena = chunk->arena_;
+  if (arena->Deallocate(chunk)) {
+    delete arena;
+  }
+}
+
+BufferChunk* BufferPool::AllocateFromCurrent(std::size_t size) {
+  if (current_pool) {
+    return current_pool->Allocate(size);
+  }
+
+  return AllocateHeapChunk(size, kHeapSizeClass);
+}
+
+BufferPool* BufferPool::Current() { return current_pool; }
+
+}  // namespace utils
+}  // namespace nekit
@@ -20,25 +20,91 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
-#include <cassert>
-
 #include "nekit/utils/cancelable.h"
 
+#include <cstddef>
+#include <utility>
+
+#include <boost/assert.hpp>
+
 namespace nekit {
 namespace utils {
-Cancelable::Cancelable() : canceled_{std::make_shared<bool>(false)} {}
 
-Cancelable::Cancelable(const Cancelable& cancelable) {
-  canceled_ = cancelable.canceled_;
+namespace {
+// Released tokens are kept for reuse by the thread, up to this many.
+const size_t kMaxFreeTokens = 4096;
+
+// Plain thread locals stay valid until the thread exits, the cancelables
+// released while the thread is exiting just free their tokens.
+thread_local Cancelable::Token* free_tokens = nullptr;
+thread_local size_t free_token_count = 0;
+thread_local bool pool_closed = false;
+
+struct TokenPoolCleaner {
+  ~TokenPoolCleaner() {
+    pool_closed = true;
+    while (free_tokens) {
+      auto token = free_tokens;
+      free_tokens = token->next;
+      delete token;
+    }
+    free_token_count = 0;
+  }
+};
+
+thread_local TokenPoolCleaner cleaner;
+}  // namespace
+
+Cancelable::Token* Cancelable::AcquireToken() {
+  Token* token = free_tokens;
+  if (token) {
+    free_tokens = token->next;
+    free_token_count--;
+  } else {
+    // Make sure the free tokens are released when the thread exits.
+    (void)&cleaner;
+    token = new Token;
+  }
+
+  token->references = 1;
+  token->canceled = false;
+  token->next = nullptr;
+  return token;
+}
+
+void Cancelable::ReleaseToken(Token* token) {
+  if (!token || --token->references) {
+    return;
+  }
+
+  if (pool_closed || free_token_count >= kMaxFreeTokens) {
+    delete token;
+    return;
+  }
+
+  token->next = free_tokens;
+  free_tokens = token;
+  free_token_count++;
+}
+
+Cancelable::Cancelable() : token_{AcquireToken()} {}
+
+Cancelable::~Cancelable() { ReleaseToken(token_); }
+
+Cancelable::Cancelable(const Cancelable& cancelable)
+    : token_{cancelable.token_} {
+  if (token_) token_->references++;
 }
 
 Cancelable& Cancelable::operator=(const nekit::utils::Cancelable& cancelable) {
-  canceled_ = cancelable.canceled_;
+  if (cancelable.token_) cancelable.token_->references++;
+  ReleaseToken(token_);
+  token_ = cancelable.token_;
   return *this;
 }
 
-Cancelable::Cancelable(Cancelable&& cancelable) {
-  cancelable.canceled_.swap(canceled_);
+Cancelable::Cancelable(Cancelable&& cancelable) : token_{cancelable.token_} {
+  cancelable.token_ = nullptr;
 }
 
 Cancelable& Cancelable::operator=(Cancelable&& cancelable) {
@@ -46,17 +112,25 @@ Cancelable& Cancelable::operator=(Cancelable&& cancelable) {
     return *this;
   }
 
-  cancelable.canceled_.swap(canceled_);
+  std::swap(token_, cancelable.token_);
   return *this;
 }
 
 void Cancelable::Cancel() {
-  if (canceled_) *canceled_ = true;
+  if (token_) token_->canceled = true;
+}
+
+void Cancelable::Reset() {
+  ReleaseToken(token_);
+  token_ = AcquireToken();
 }
 
-void Cancelable::Reset() { canceled_ = std::make_shared<bool>(false); }
+bool Cancelable::canceled() const {
+  BOOST_ASSERT(token_);
+  return token_->canceled;
+}
 
-bool Cancelable::canceled() const { return *canceled_; }
+size_t Cancelable::FreeTokenCount() { return free_token_count; }
 
 }  // namespace utils
 }  // namespace nekit
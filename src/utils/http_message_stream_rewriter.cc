@@ -88,16 +88,12 @@ class HttpMessageStreamRewriterImpl {
     parser_.data = this;
   }
 
-  ~HttpMessageStreamRewriterImpl() { free(pending_previous_buffer_); }
+  ~HttpMessageStreamRewriterImpl() = default;
 
   utils::Result<void> RewriteBuffer(Buffer* buffer) {
-    if (pending_buffer_length_) {
-      buffer->InsertFront(pending_buffer_length_);
-      buffer->SetData(0, pending_buffer_length_, pending_previous_buffer_);
-      current_buffer_offset_ = pending_buffer_length_;
-      pending_buffer_length_ = 0;
-      free(pending_previous_buffer_);
-      pending_previous_buffer_ = nullptr;
+    if (pending_previous_buffer_) {
+      current_buffer_offset_ = pending_previous_buffer_.size();
+      buffer->InsertFront(std::move(pending_previous_buffer_));
     } else {
       current_buffer_offset_ = 0;
     }
@@ -108,10 +104,8 @@ class HttpMessageStreamRewriterImpl {
       // Unpause it first.
       http_parser_pause(&parser_, 0);
 
-      buffer->WalkInternalChunk(
-          [this](void* data, size_t len, void* context) {
-            (void)context;
-
+      buffer->ForEachChunk(
+          [this](void* data, size_t len) {
             int parsed = http_parser_execute(&parser_, &parser_settings_,
                                              static_cast<char*>(data), len);
 
@@ -215,7 +209,7 @@ class HttpMessageStreamRewriterImpl {
 
             return false;
           },
-          current_buffer_offset_, nullptr);
+          current_buffer_offset_);
     }
 
     if (errored_) {
@@ -231,17 +225,14 @@ class HttpMessageStreamRewriterImpl {
     }
 
     if (current_token_offset_ != buffer->size()) {
-      pending_buffer_length_ = buffer->size() - current_token_offset_;
-
-      if (pending_buffer_length_ > NEKIT_HTTP_STREAM_REWRITER_MAX_BUFFER_SIZE) {
+      if (buffer->size() - current_token_offset_ >
+          NEKIT_HTTP_STREAM_REWRITER_MAX_BUFFER_SIZE) {
         return utils::MakeErrorResult(
             HttpMessageStreamRewriterErrorCode::BlockTooLong);
       }
 
-      pending_previous_buffer_ = malloc(pending_buffer_length_);
-      buffer->GetData(current_token_offset_, pending_buffer_length_,
-                      pending_previous_buffer_);
-      buffer->ShrinkBack(pending_buffer_length_);
+      // The chunks are shared, no data is copied.
+      pending_previous_buffer_ = buffer->Break(current_token_offset_);
 
       current_token_end_offset_ -= current_token_offset_;
       current_header_field_offset_ -= current_token_offset_;
@@ -651,8 +642,7 @@ class HttpMessageStreamRewriterImpl {
 
   Buffer* current_buffer_;
 
-  void* pending_previous_buffer_{nullptr};
-  size_t pending_buffer_length_{0};
+  Buffer pending_previous_buffer_;
 
   size_t current_buffer_offset_{0};
   size_t current_token_offset_{0};
@@ -0,0 +1,138 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "nekit/utils/memory_budget.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <boost/assert.hpp>
+
+namespace nekit {
+namespace utils {
+
+MemoryBudget::Reservation::Reservation(MemoryBudget* budget, size_t size)
+    : budget_{budget}, size_{size} {
+  budget_->Charge(size_);
+}
+
+MemoryBudget::Reservation::Reservation(Reservation&& reservation) {
+  *this = std::move(reservation);
+}
+
+MemoryBudget::Reservation& MemoryBudget::Reservation::operator=(
+    Reservation&& reservation) {
+  if (&reservation == this) {
+    return *this;
+  }
+
+  Release();
+  budget_ = reservation.budget_;
+  size_ = reservation.size_;
+  reservation.budget_ = nullptr;
+  reservation.size_ = 0;
+  return *this;
+}
+
+MemoryBudget::Reservation::~Reservation() { Release(); }
+
+void MemoryBudget::Reservation::Release() {
+  if (budget_) {
+    // Clear first, the waiters may reuse this reservation.
+    auto budget = budget_;
+    budget_ = nullptr;
+    budget->Release(size_);
+  }
+  size_ = 0;
+}
+
+size_t MemoryBudget::Reservation::size() const { return size_; }
+
+MemoryBudget::MemoryBudget(size_t limit, MemoryBudget* parent)
+    : limit_{limit}, parent_{parent} {}
+
+MemoryBudget::~MemoryBudget() { BOOST_ASSERT(!current_); }
+
+size_t MemoryBudget::limit() const { return limit_; }
+
+void MemoryBudget::set_limit(size_t limit) {
+  limit_ = limit;
+  // Raising the limit may make room for the waiters.
+  Release(0);
+}
+
+size_t MemoryBudget::current() const { return current_; }
+
+size_t MemoryBudget::peak() const { return peak_; }
+
+bool MemoryBudget::Available() const {
+  for (auto budget = this; budget; budget = budget->parent_) {
+    if (budget->Exhausted()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+MemoryBudget::Reservation MemoryBudget::Reserve(size_t size) {
+  return Reservation(this, size);
+}
+
+void MemoryBudget::Wait(EventHandler handler) {
+  for (auto budget = this; budget; budget = budget->parent_) {
+    if (budget->Exhausted()) {
+      budget->waiters_.push_back(std::move(handler));
+      return;
+    }
+  }
+
+  handler();
+}
+
+bool MemoryBudget::Exhausted() const { return limit_ && current_ >= limit_; }
+
+void MemoryBudget::Charge(size_t size) {
+  current_ += size;
+  peak_ = std::max(peak_, current_);
+
+  if (parent_) {
+    parent_->Charge(size);
+  }
+}
+
+void MemoryBudget::Release(size_t size) {
+  BOOST_ASSERT(current_ >= size);
+  current_ -= size;
+
+  if (parent_) {
+    parent_->Release(size);
+  }
+
+  if (!Exhausted() && !waiters_.empty()) {
+    std::vector<EventHandler> waiters;
+    waiters.swap(waiters_);
+    for (auto& waiter : waiters) {
+      waiter();
+    }
+  }
+}
+}  // namespace utils
+}  // namespace nekit
@@ -22,12 +22,14 @@
 
 #include "nekit/utils/stream_reader.h"
 
-#include <boost/asio/buffer.hpp>
+#include <algorithm>
 
 namespace nekit {
 namespace utils {
 StreamReader::StreamReader(data_flow::DataFlowInterface* data_flow)
-    : data_flow_{data_flow} {}
+    : data_flow_{data_flow} {
+  buffer_.EnableCompaction();
+}
 
 StreamReader::~StreamReader() {
   data_flow_cancelable_.Cancel();
@@ -89,11 +91,8 @@ Cancelable StreamReader::ReadToPattern(
 
   cancelable_ = Cancelable();
   handler_ = handler;
-  pattern_matcher_ = std::make_unique<
-      boost::algorithm::knuth_morris_pratt<std::string::const_iterator>>(
-      pattern.begin(), pattern.end());
+  pattern_ = std::move(pattern);
   last_pos_ = 0;
-  pattern_size_ = pattern.size();
 
   DoReadPattern();
 
@@ -101,20 +100,10 @@ Cancelable StreamReader::ReadToPattern(
 }
 
 void StreamReader::DoReadPattern() {
-  std::vector<boost::asio::const_buffer> buffers;
-  buffer_.WalkInternalChunk(
-      [&](const void* data, size_t len, void* context) {
-        (void)context;
-        buffers.emplace_back(data, len);
-        return true;
-      },
-      last_pos_, nullptr);
-
-  auto result = (*pattern_matcher_)(boost::asio::buffers_begin(buffers),
-                                    boost::asio::buffers_end(buffers))
-                    .first;
-  if (result == boost::asio::buffers_end(buffers)) {
-    last_pos_ = buffer_.size() - std::min(buffer_.size(), pattern_size_);
+  size_t pos = buffer_.Find(pattern_.data(), pattern_.size(), last_pos_);
+  if (pos == Buffer::npos) {
+    // The pattern may start in the last `pattern_.size() - 1` bytes.
+    last_pos_ = buffer_.size() - std::min(buffer_.size(), pattern_.size() - 1);
 
     data_flow_cancelable_ = data_flow_->Read([this](Result<Buffer>&& buffer) {
       if (cancelable_.canceled()) {
@@ -129,8 +118,7 @@ void StreamReader::DoReadPattern() {
       DoReadPattern();
     });
   } else {
-    size_t len = std::distance(boost::asio::buffers_begin(buffers), result) +
-                 pattern_size_ + last_pos_;
+    size_t len = pos + pattern_.size();
 
     Buffer b = std::move(buffer_);
     if (b.size() != len) {
@@ -22,6 +22,8 @@
 
 #include "nekit/utils/system_resolver.h"
 
+#include <boost/assert.hpp>
+
 #include "nekit/utils/boost_error.h"
 #include "nekit/utils/error.h"
 #include "nekit/utils/log.h"
@@ -54,8 +56,11 @@ Cancelable SystemResolver::Resolve(std::string domain,
 
   Cancelable cancelable{};
 
-  resolve_runloop_.Post([this, domain, handler, cancelable,
-                         lifetime{lifetime_}]() mutable {
+  uint64_t id = next_request_id_++;
+  requests_.emplace(id, Request{handler, cancelable});
+
+  resolve_runloop_.Post([this, id, domain,
+                         lifetime{std::weak_ptr<bool>(lifetime_)}]() {
     // Note it will be guaranteed that the `runloop_` will never be
     // released before all the instances implementing `AsyncInterface`
     // which will return that `runloop_` are released. This resolver will
@@ -64,10 +69,6 @@ Cancelable SystemResolver::Resolve(std::string domain,
     // there is no need to worry about any thread issues here. Resolver and
     // `runloop_` will exist when this thread is running.
 
-    if (cancelable.canceled() || lifetime.canceled()) {
-      return;
-    }
-
     auto resolver =
         boost::asio::ip::tcp::resolver(*resolve_runloop_.BoostIoContext());
 
@@ -80,13 +81,12 @@ Cancelable SystemResolver::Resolve(std::string domain,
       auto error = BoostErrorCategory::FromBoostError(ec);
       NEERROR << "Failed to resolve " << domain << " due to " << error << ".";
 
-      runloop_->Post([handler, error{std::move(error)}, cancelable,
-                      life_time{lifetime_}]() mutable {
-        if (cancelable.canceled() || life_time.canceled()) {
+      runloop_->Post([this, id, error{std::move(error)}, lifetime]() mutable {
+        if (lifetime.expired()) {
           return;
         }
 
-        handler(utils::MakeErrorResult(std::move(error)));
+        FinishRequest(id, utils::MakeErrorResult(std::move(error)));
       });
       return;
     }
@@ -99,18 +99,35 @@ Cancelable SystemResolver::Resolve(std::string domain,
 
     NEINFO << "Successfully resolved domain " << domain << ".";
 
-    runloop_->Post([handler, addresses, cancelable, life_time{lifetime_}]() {
-      if (cancelable.canceled() || life_time.canceled()) {
+    runloop_->Post([this, id, addresses, lifetime]() {
+      if (lifetime.expired()) {
         return;
       }
 
-      handler(addresses);
+      FinishRequest(id, addresses);
     });
   });
 
   return cancelable;
 }
 
+void SystemResolver::FinishRequest(
+    uint64_t id,
+    utils::Result<std::shared_ptr<std::vector<boost::asio::ip::address>>>&&
+        result) {
+  auto iter = requests_.find(id);
+  BOOST_ASSERT(iter != requests_.end());
+
+  Request request = std::move(iter->second);
+  requests_.erase(iter);
+
+  if (request.cancelable.canceled()) {
+    return;
+  }
+
+  request.handler(std::move(result));
+}
+
 void SystemResolver::Stop() {
   work_guard_.reset();
   thread_group_.join_all();
@@ -118,7 +135,7 @@ void SystemResolver::Stop() {
 
 SystemResolver::~SystemResolver() {
   Stop();
-  lifetime_.Cancel();
+  lifetime_.reset();
 }
 
 utils::Runloop* SystemResolver::GetRunloop() { return runloop_; }
@@ -58,5 +58,20 @@ void Timer::Cancel() {
 }
 
 utils::Runloop* Timer::GetRunloop() { return runloop_; }
+
+WheelTimer::WheelTimer(utils::Runloop* runloop, std::function<void()> handler)
+    : runloop_{runloop}, handler_{handler} {}
+
+WheelTimer::~WheelTimer() { Cancel(); }
+
+void WheelTimer::Wait(uint32_t milliseconds) {
+  runloop_->GetTimerWheel()->Arm(this, milliseconds);
+}
+
+void WheelTimer::Cancel() { runloop_->GetTimerWheel()->Disarm(this); }
+
+utils::Runloop* WheelTimer::GetRunloop() { return runloop_; }
+
+void WheelTimer::OnExpire() { handler_(); }
 }  // namespace utils
 }  // namespace nekit
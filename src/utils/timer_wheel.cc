@@ -0,0 +1,213 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "nekit/utils/timer_wheel.h"
+
+#include <boost/assert.hpp>
+
+#define SLOT_MASK (NEKIT_TIMER_WHEEL_SLOT_COUNT - 1)
+
+static_assert((NEKIT_TIMER_WHEEL_SLOT_COUNT & SLOT_MASK) == 0,
+              "The slot count of the timer wheel must be a power of two.");
+
+namespace nekit {
+namespace utils {
+
+TimerWheel::Entry::Entry() : Link{nullptr, nullptr} {}
+
+TimerWheel::Entry::~Entry() {
+  if (wheel_) {
+    wheel_->Disarm(this);
+  }
+}
+
+bool TimerWheel::Entry::armed() const { return wheel_; }
+
+TimerWheel::TimerWheel(boost::asio::io_context* io_context)
+    : slots_{new Link[NEKIT_TIMER_WHEEL_SLOT_COUNT]},
+      epoch_{Clock::now()},
+      timer_{*io_context} {
+  for (size_t i = 0; i < NEKIT_TIMER_WHEEL_SLOT_COUNT; i++) {
+    slots_[i].prev = slots_[i].next = &slots_[i];
+  }
+}
+
+TimerWheel::~TimerWheel() {
+  for (size_t i = 0; i < NEKIT_TIMER_WHEEL_SLOT_COUNT; i++) {
+    while (slots_[i].next != &slots_[i]) {
+      Disarm(static_cast<Entry*>(slots_[i].next));
+    }
+  }
+}
+
+void TimerWheel::Arm(Entry* entry, uint32_t milliseconds) {
+  BOOST_ASSERT(!entry->wheel_ || entry->wheel_ == this);
+
+  uint64_t deadline = Now() + (milliseconds + NEKIT_TIMER_WHEEL_TICK - 1) /
+                                  NEKIT_TIMER_WHEEL_TICK;
+  // Every slot up to the current tick may have been visited already.
+  if (deadline <= current_tick_) {
+    deadline = current_tick_ + 1;
+  }
+  entry->deadline_ = deadline;
+
+  if (entry->wheel_) {
+    if (deadline >= entry->slot_tick_) {
+      return;
+    }
+    Remove(entry);
+  } else {
+    entry->wheel_ = this;
+    size_++;
+  }
+
+  Insert(entry, deadline);
+  Schedule(deadline);
+}
+
+void TimerWheel::Disarm(Entry* entry) {
+  if (!entry->wheel_) {
+    return;
+  }
+
+  BOOST_ASSERT(entry->wheel_ == this);
+
+  Remove(entry);
+  entry->wheel_ = nullptr;
+
+  if (--size_ == 0 && scheduled_) {
+    timer_.cancel();
+    scheduled_ = false;
+  }
+}
+
+size_t TimerWheel::size() const { return size_; }
+
+uint64_t TimerWheel::Now() const {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                               epoch_)
+             .count() /
+         NEKIT_TIMER_WHEEL_TICK;
+}
+
+void TimerWheel::Insert(Entry* entry, uint64_t tick) {
+  Link* slot = &slots_[tick & SLOT_MASK];
+  entry->slot_tick_ = tick;
+  entry->prev = slot->prev;
+  entry->next = slot;
+  slot->prev->next = entry;
+  slot->prev = entry;
+}
+
+void TimerWheel::Remove(Link* link) {
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+  link->prev = link->next = nullptr;
+}
+
+void TimerWheel::Schedule(uint64_t tick) {
+  if (scheduled_ && scheduled_tick_ <= tick) {
+    return;
+  }
+
+  scheduled_ = true;
+  scheduled_tick_ = tick;
+  timer_.expires_at(epoch_ +
+                    std::chrono::milliseconds(tick * NEKIT_TIMER_WHEEL_TICK));
+  timer_.async_wait([this](const boost::system::error_code& ec) {
+    if (ec == boost::asio::error::operation_aborted) {
+      return;
+    }
+
+    scheduled_ = false;
+    Advance();
+  });
+}
+
+void TimerWheel::Advance() {
+  uint64_t now = Now();
+  if (now <= current_tick_) {
+    ScheduleNext();
+    return;
+  }
+
+  // Each slot only has to be visited once even if the wheel has been asleep
+  // for more than one revolution.
+  uint64_t tick = current_tick_ + 1;
+  if (now - current_tick_ > NEKIT_TIMER_WHEEL_SLOT_COUNT) {
+    tick = now - NEKIT_TIMER_WHEEL_SLOT_COUNT + 1;
+  }
+  current_tick_ = now;
+
+  Link pending;
+  for (; tick <= now; tick++) {
+    Link* slot = &slots_[tick & SLOT_MASK];
+    if (slot->next == slot) {
+      continue;
+    }
+
+    // Move the entries out of the slot, expiring one may arm, disarm or
+    // release any other.
+    pending.next = slot->next;
+    pending.prev = slot->prev;
+    pending.next->prev = pending.prev->next = &pending;
+    slot->prev = slot->next = slot;
+
+    while (pending.next != &pending) {
+      Entry* entry = static_cast<Entry*>(pending.next);
+      Remove(entry);
+
+      if (entry->slot_tick_ > now) {
+        // Linked for a later revolution.
+        Insert(entry, entry->slot_tick_);
+      } else if (entry->deadline_ > now) {
+        Insert(entry, entry->deadline_);
+      } else {
+        entry->wheel_ = nullptr;
+        size_--;
+        entry->OnExpire();
+      }
+    }
+  }
+
+  ScheduleNext();
+}
+
+void TimerWheel::ScheduleNext() {
+  if (!size_) {
+    return;
+  }
+
+  // The entries expiring may have scheduled a later wakeup already.
+
+  for (uint64_t tick = current_tick_ + 1;
+       tick <= current_tick_ + NEKIT_TIMER_WHEEL_SLOT_COUNT; tick++) {
+    Link* slot = &slots_[tick & SLOT_MASK];
+    if (slot->next != slot) {
+      Schedule(tick);
+      return;
+    }
+  }
+}
+
+}  // namespace utils
+}  // namespace nekit
@@ -20,11 +20,19 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <random>
+#include <string>
 
 #include <gtest/gtest.h>
 
 #include <nekit/utils/buffer.h>
+#include <nekit/utils/buffer_pool.h>
+#include <nekit/utils/buffer_sequence.h>
+#include <nekit/utils/pool_allocator.h>
 
 using namespace nekit;
 
@@ -123,3 +131,392 @@ TEST(BufferBreakTest, CheckChunkedBufferBreak) {
   EvaluateBufferRange(buffer.get(), 0, 20, 0);
   EvaluateBufferRange(&b, 0, 10, 20);
 }
+
+TEST(BufferBreakTest, CheckBreakAtBoundary) {
+  auto buffer = BufferFactory::ChunkedBuffer(10, 3);
+  FillBuffer(buffer.get(), 0, 30, 0);
+
+  auto b = buffer->Break(30);
+  EXPECT_EQ(b.size(), 0);
+  EXPECT_EQ(buffer->size(), 30);
+
+  b = buffer->Break(0);
+  EXPECT_EQ(b.size(), 30);
+  EXPECT_EQ(buffer->size(), 0);
+  EvaluateBufferRange(&b, 0, 30, 0);
+}
+
+TEST(BufferBreakTest, CheckModifyAfterBreak) {
+  auto buffer = BufferFactory::WholeBuffer(30);
+  FillBuffer(buffer.get(), 0, 30, 0);
+  auto b = buffer->Break(20);
+
+  FillBuffer(&b, 0, 10, 100);
+  buffer->InsertBack(10);
+  FillBuffer(buffer.get(), 20, 10, 200);
+  b.InsertFront(5);
+  FillBuffer(&b, 0, 5, 50);
+
+  EvaluateBufferRange(buffer.get(), 0, 20, 0);
+  EvaluateBufferRange(buffer.get(), 20, 10, 200);
+  EvaluateBufferRange(&b, 0, 5, 50);
+  EvaluateBufferRange(&b, 5, 10, 100);
+}
+
+TEST(BufferBreakTest, CheckBreakWithoutCopy) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+
+  utils::Buffer buffer{4096};
+  auto allocated_bytes = pool.GetStatistics().allocated_bytes;
+  auto b = buffer.Break(1000);
+  buffer.Insert(500, 10);
+  EXPECT_LT(pool.GetStatistics().allocated_bytes, allocated_bytes + 1000);
+}
+
+TEST(BufferShareTest, CheckCopyOnWrite) {
+  auto buffer = BufferFactory::ChunkedBuffer(10, 3);
+  FillBuffer(buffer.get(), 0, 30, 0);
+
+  auto b = buffer->Share(5, 20);
+  EXPECT_EQ(b.size(), 20);
+  EvaluateBufferRange(&b, 0, 20, 5);
+
+  FillBuffer(&b, 0, 10, 100);
+  EvaluateBufferRange(buffer.get(), 0, 30, 0);
+  EvaluateBufferRange(&b, 0, 10, 100);
+  EvaluateBufferRange(&b, 10, 10, 15);
+
+  FillBuffer(buffer.get(), 10, 20, 200);
+  EvaluateBufferRange(&b, 10, 10, 15);
+
+  auto c = b.Share(0, 20);
+  b = utils::Buffer();
+  FillBuffer(&c, 0, 20, 50);
+  EvaluateBufferRange(&c, 0, 20, 50);
+  EvaluateBufferRange(buffer.get(), 0, 10, 0);
+  EvaluateBufferRange(buffer.get(), 10, 20, 200);
+}
+
+TEST(BufferShrinkTest, CheckShrinkBack) {
+  auto buffer = BufferFactory::ChunkedBuffer(10, 3);
+  FillBuffer(buffer.get(), 0, 30, 0);
+
+  buffer->ShrinkBack(5);
+  EXPECT_EQ(buffer->size(), 25);
+  buffer->ShrinkBack(15);
+  EXPECT_EQ(buffer->size(), 10);
+  EvaluateBufferRange(buffer.get(), 0, 10, 0);
+
+  buffer->InsertBack(20);
+  FillBuffer(buffer.get(), 10, 20, 10);
+  EvaluateBufferRange(buffer.get(), 0, 30, 0);
+
+  buffer->ShrinkBack(30);
+  EXPECT_EQ(buffer->size(), 0);
+  buffer->InsertBack(10);
+  FillBuffer(buffer.get(), 0, 10, 0);
+  EvaluateBufferRange(buffer.get(), 0, 10, 0);
+}
+
+TEST(BufferCursorTest, CheckSequentialAccess) {
+  auto buffer = BufferFactory::ChunkedBuffer(3, 20);
+
+  size_t i = 0;
+  for (auto cursor = buffer->CursorAt(0); !cursor.AtEnd(); ++cursor) {
+    EXPECT_EQ(cursor.position(), i);
+    *cursor = i++;
+  }
+  EXPECT_EQ(i, 60);
+
+  const utils::Buffer& const_buffer = *buffer;
+  auto cursor = const_buffer.CursorAt(10);
+  EXPECT_EQ(*cursor, 10);
+  EXPECT_EQ(cursor.contiguous_size(), 2);
+  cursor += 25;
+  EXPECT_EQ(*cursor, 35);
+  cursor += 25;
+  EXPECT_TRUE(cursor.AtEnd());
+  EXPECT_TRUE(cursor == const_buffer.CursorAt(60));
+}
+
+TEST(BufferCursorTest, CheckRandomAccessOnManyChunks) {
+  auto buffer = BufferFactory::ChunkedBuffer(1, 200);
+  FillBuffer(buffer.get(), 0, 200, 0);
+
+  for (size_t i = 0; i < 200; i += 7) {
+    EXPECT_EQ((*buffer)[199 - i], 199 - i);
+    EXPECT_EQ((*buffer)[i], i);
+  }
+
+  buffer->Shrink(50, 100);
+  EvaluateBufferRange(buffer.get(), 0, 50, 0);
+  EvaluateBufferRange(buffer.get(), 50, 50, 150);
+}
+
+TEST(BufferChunkTest, CheckForEachChunk) {
+  auto buffer = BufferFactory::ChunkedBuffer(10, 3);
+  FillBuffer(buffer.get(), 0, 30, 0);
+
+  size_t count = 0, len = 0;
+  static_cast<const utils::Buffer&>(*buffer).ForEachChunk(
+      [&](const uint8_t* data, size_t size) {
+        EXPECT_EQ(*data, 15 + len);
+        len += size;
+        return ++count < 2;
+      },
+      15);
+  EXPECT_EQ(count, 2);
+  EXPECT_EQ(len, 15);
+}
+
+TEST(BufferChunkTest, CheckBufferSequence) {
+  auto buffer = BufferFactory::ChunkedBuffer(10, 3);
+  FillBuffer(buffer.get(), 0, 30, 0);
+
+  utils::ConstBufferSequence sequence{*buffer, 5};
+  EXPECT_EQ(boost::asio::buffer_size(sequence), 25);
+  EXPECT_EQ(std::distance(sequence.begin(), sequence.end()), 3);
+
+  uint8_t data[30];
+  boost::asio::buffer_copy(boost::asio::buffer(data), sequence);
+  for (size_t i = 0; i < 25; i++) {
+    EXPECT_EQ(data[i], i + 5);
+  }
+
+  auto shared = buffer->Share(0, 30);
+  utils::MutableBufferSequence mutable_sequence{shared};
+  std::memset(data, 0, sizeof(data));
+  boost::asio::buffer_copy(mutable_sequence, boost::asio::buffer(data));
+  EXPECT_EQ(shared[0], 0);
+  EXPECT_EQ(shared[29], 0);
+  EvaluateBufferRange(buffer.get(), 0, 30, 0);
+
+  auto iter = mutable_sequence.end();
+  --iter;
+  EXPECT_EQ(boost::asio::buffer_size(*iter), 10);
+  EXPECT_EQ(boost::asio::buffer_size(utils::ConstBufferSequence{shared, 30}),
+            0);
+}
+
+TEST(BufferCompactionTest, CheckChunkCount) {
+  auto buffer = BufferFactory::ChunkedBuffer(10, 3);
+  EXPECT_EQ(buffer->chunk_count(), 3);
+
+  auto b = buffer->Break(15);
+  EXPECT_EQ(buffer->chunk_count(), 2);
+  EXPECT_EQ(b.chunk_count(), 2);
+
+  buffer->Insert(std::move(b), 5);
+  EXPECT_EQ(buffer->chunk_count(), 5);
+  EXPECT_EQ(buffer->size(), 30);
+
+  buffer->Shrink(0, 20);
+  EXPECT_EQ(buffer->chunk_count(), 2);
+  buffer->ShrinkBack(10);
+  EXPECT_EQ(buffer->chunk_count(), 0);
+}
+
+TEST(BufferCompactionTest, CheckCompaction) {
+  utils::Buffer buffer;
+  buffer.EnableCompaction(8);
+
+  for (size_t i = 0; i < 100; i++) {
+    utils::Buffer piece{3};
+    FillBuffer(&piece, 0, 3, i * 3);
+    buffer.InsertBack(std::move(piece));
+    EXPECT_LE(buffer.chunk_count(), 8);
+  }
+
+  EXPECT_EQ(buffer.size(), 300);
+  EvaluateBufferRange(&buffer, 0, 250, 0);
+
+  buffer.DisableCompaction();
+  buffer.InsertBack(utils::Buffer(4096));
+  buffer.InsertBack(utils::Buffer(1));
+  buffer.InsertBack(utils::Buffer(1));
+  buffer.Compact();
+  EXPECT_EQ(buffer.chunk_count(), 3);
+  EXPECT_EQ(buffer.size(), 300 + 4096 + 2);
+  EvaluateBufferRange(&buffer, 0, 250, 0);
+}
+
+utils::Buffer MakeBuffer(const std::string& data, size_t chunk_size) {
+  utils::Buffer buffer;
+  for (size_t i = 0; i < data.size(); i += chunk_size) {
+    size_t len = std::min(chunk_size, data.size() - i);
+    utils::Buffer piece{len};
+    piece.SetData(0, len, data.data() + i);
+    buffer.InsertBack(std::move(piece));
+  }
+  return buffer;
+}
+
+TEST(BufferFindTest, CheckFindInChunk) {
+  std::string data(300, 'a');
+  data.replace(200, 4, "\r\n\r\n");
+  auto buffer = MakeBuffer(data, data.size());
+
+  EXPECT_EQ(buffer.Find("\r\n\r\n", 4), 200);
+  EXPECT_EQ(buffer.Find("\n", 1, 202), 203);
+  EXPECT_EQ(buffer.Find("\r\n\r\n", 4, 201), utils::Buffer::npos);
+  EXPECT_EQ(buffer.Find("ab", 2), utils::Buffer::npos);
+  EXPECT_EQ(buffer.Find(data.data(), data.size()), 0);
+}
+
+TEST(BufferFindTest, CheckFindAcrossChunks) {
+  auto buffer = MakeBuffer("GET / HTTP/1.1\r\nHost: a\r\n\r\nbody", 1);
+
+  EXPECT_EQ(buffer.Find("\r\n\r\n", 4), 23);
+  EXPECT_EQ(buffer.Find("\r\n", 2, 17), 23);
+  EXPECT_EQ(buffer.Find("body!", 5), utils::Buffer::npos);
+
+  buffer = MakeBuffer("abcabcabd", 4);
+  EXPECT_EQ(buffer.Find("abcabd", 6), 3);
+}
+
+TEST(BufferFindTest, CheckFindMatchesString) {
+  std::mt19937 engine{42};
+  std::uniform_int_distribution<int> byte{'a', 'c'};
+
+  for (size_t round = 0; round < 200; round++) {
+    std::string data(engine() % 200 + 1, 'a');
+    for (auto& c : data) {
+      c = static_cast<char>(byte(engine));
+    }
+    std::string pattern(engine() % 5 + 1, 'a');
+    for (auto& c : pattern) {
+      c = static_cast<char>(byte(engine));
+    }
+    size_t from = engine() % (data.size() + 1);
+
+    auto buffer = MakeBuffer(data, engine() % 40 + 1);
+    size_t expected = data.find(pattern, from);
+    EXPECT_EQ(buffer.Find(pattern.data(), pattern.size(), from),
+              expected == std::string::npos ? utils::Buffer::npos : expected);
+  }
+}
+
+TEST(BufferPoolTest, RecycleChunk) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+
+  { utils::Buffer buffer{1000}; }
+  auto statistics = pool.GetStatistics();
+  EXPECT_EQ(statistics.hit_count, 0);
+  EXPECT_GT(statistics.miss_count, 0);
+  EXPECT_EQ(statistics.allocated_bytes, 0);
+  EXPECT_GT(statistics.resident_bytes, 0);
+
+  {
+    utils::Buffer buffer{1000};
+    EXPECT_GT(pool.GetStatistics().allocated_bytes, 1000);
+  }
+  statistics = pool.GetStatistics();
+  EXPECT_GT(statistics.hit_count, 0);
+  EXPECT_EQ(statistics.allocated_bytes, 0);
+}
+
+TEST(BufferPoolTest, UseSlackCapacity) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+
+  utils::Buffer buffer{1000};
+  auto statistics = pool.GetStatistics();
+  buffer.InsertBack(24);
+  EXPECT_EQ(buffer.size(), 1024);
+  EXPECT_EQ(pool.GetStatistics().miss_count, statistics.miss_count);
+}
+
+TEST(BufferPoolTest, CheckMemorySize) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+
+  utils::Buffer buffer{1000};
+  EXPECT_EQ(buffer.memory_size(), 1024);
+
+  // The shared chunk is not counted by either buffer.
+  auto second = buffer.Break(600);
+  EXPECT_EQ(buffer.memory_size(), 0);
+  EXPECT_EQ(second.memory_size(), 0);
+
+  // Counted once when all the views are in one buffer again.
+  buffer.InsertBack(std::move(second));
+  EXPECT_EQ(buffer.memory_size(), 1024);
+
+  auto shared = buffer.Share(0, 100);
+  EXPECT_EQ(buffer.memory_size(), 0);
+  shared = utils::Buffer();
+  EXPECT_EQ(buffer.memory_size(), 1024);
+}
+
+TEST(BufferPoolTest, LargeChunk) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+
+  {
+    utils::Buffer buffer{1024 * 1024};
+    FillBuffer(&buffer, 0, 200, 0);
+    EvaluateBufferRange(&buffer, 0, 200, 0);
+  }
+  EXPECT_EQ(pool.GetStatistics().allocated_bytes, 0);
+}
+
+TEST(BufferPoolTest, ReserveSpace) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+
+  utils::Buffer buffer{100, utils::BufferReserveSize{20, 30}};
+  EXPECT_EQ(buffer.size(), 100);
+  FillBuffer(&buffer, 0, 100, 20);
+
+  auto statistics = pool.GetStatistics();
+  buffer.InsertFront(20);
+  buffer.InsertBack(30);
+  EXPECT_EQ(buffer.size(), 150);
+  EXPECT_EQ(pool.GetStatistics().allocated_bytes, statistics.allocated_bytes);
+
+  FillBuffer(&buffer, 0, 20, 0);
+  EvaluateBufferRange(&buffer, 0, 120, 0);
+}
+
+TEST(BufferPoolTest, OutlivePool) {
+  std::unique_ptr<utils::Buffer> buffer;
+  {
+    utils::BufferPool pool;
+    utils::BufferPool::Scope scope{&pool};
+    buffer = BufferFactory::ChunkedBuffer(80, 3);
+  }
+  FillBuffer(buffer.get(), 0, 240, 0);
+  EvaluateBufferRange(buffer.get(), 0, 240, 0);
+}
+
+TEST(BufferPoolTest, PoolAllocatedObject) {
+  struct Object : public utils::PoolAllocated {
+    char data[100];
+  };
+
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+
+  delete new Object();
+  auto statistics = pool.GetStatistics();
+  EXPECT_EQ(statistics.allocated_bytes, 0);
+
+  auto object = std::make_unique<Object>();
+  EXPECT_EQ(pool.GetStatistics().hit_count, statistics.hit_count + 1);
+  EXPECT_GT(pool.GetStatistics().allocated_bytes, 100);
+}
+
+TEST(BufferPoolTest, AllocateShared) {
+  utils::BufferPool pool;
+  utils::BufferPool::Scope scope{&pool};
+
+  {
+    auto value = std::allocate_shared<std::string>(
+        utils::PoolAllocator<std::string>(), "pooled");
+    EXPECT_EQ(*value, "pooled");
+    EXPECT_GT(pool.GetStatistics().allocated_bytes, 0);
+  }
+  EXPECT_EQ(pool.GetStatistics().allocated_bytes, 0);
+}
@@ -0,0 +1,114 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+
+#include <nekit/utils/cancelable.h>
+
+using namespace nekit::utils;
+
+TEST(CancelableTest, CopiesShareState) {
+  Cancelable c1;
+  Cancelable c2{c1};
+  Cancelable c3;
+  c3 = c2;
+
+  EXPECT_FALSE(c3.canceled());
+  c2.Cancel();
+  EXPECT_TRUE(c1.canceled());
+  EXPECT_TRUE(c3.canceled());
+
+  c1.Reset();
+  EXPECT_FALSE(c1.canceled());
+  EXPECT_TRUE(c2.canceled());
+}
+
+TEST(CancelableTest, MoveKeepsState) {
+  Cancelable c1;
+  Cancelable copy{c1};
+  Cancelable c2{std::move(c1)};
+  c2.Cancel();
+  EXPECT_TRUE(copy.canceled());
+
+  Cancelable c3;
+  c3 = std::move(c2);
+  EXPECT_TRUE(c3.canceled());
+}
+
+TEST(CancelableTest, ReusedTokenIsNotCanceled) {
+  {
+    Cancelable c;
+    c.Cancel();
+  }
+
+  // The released token is reused with a clean state.
+  Cancelable c;
+  EXPECT_FALSE(c.canceled());
+}
+
+TEST(CancelableTest, ReleasedToOwnThread) {
+  size_t free_count = Cancelable::FreeTokenCount();
+
+  std::thread thread([]() {
+    EXPECT_EQ(Cancelable::FreeTokenCount(), 0);
+    { Cancelable c; }
+    EXPECT_EQ(Cancelable::FreeTokenCount(), 1);
+
+    Cancelable c;
+    EXPECT_EQ(Cancelable::FreeTokenCount(), 0);
+  });
+  thread.join();
+
+  EXPECT_EQ(Cancelable::FreeTokenCount(), free_count);
+}
+
+namespace {
+size_t free_count_after_exit = static_cast<size_t>(-1);
+
+// Created before the pool of the thread, so it is destroyed after it.
+struct LateHolder {
+  ~LateHolder() {
+    cancelable.reset();
+    free_count_after_exit = Cancelable::FreeTokenCount();
+  }
+
+  std::unique_ptr<Cancelable> cancelable;
+};
+
+thread_local LateHolder late_holder;
+}  // namespace
+
+TEST(CancelableTest, FreedAfterThreadExit) {
+  std::thread thread([]() {
+    // Create the holder before the first token.
+    auto holder = &late_holder;
+    holder->cancelable = std::make_unique<Cancelable>();
+  });
+  thread.join();
+
+  // The token is deleted instead of kept in the closed pool, the memory
+  // check reports it otherwise.
+  EXPECT_EQ(free_count_after_exit, 0);
+}
@@ -0,0 +1,84 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include <nekit/utils/memory_budget.h>
+
+using namespace nekit::utils;
+
+TEST(MemoryBudgetTest, CheckCounters) {
+  MemoryBudget budget;
+
+  {
+    auto r1 = budget.Reserve(100);
+    auto r2 = budget.Reserve(50);
+    EXPECT_EQ(budget.current(), 150);
+    r1.Release();
+    EXPECT_EQ(budget.current(), 50);
+  }
+
+  EXPECT_EQ(budget.current(), 0);
+  EXPECT_EQ(budget.peak(), 150);
+  EXPECT_TRUE(budget.Available());
+}
+
+TEST(MemoryBudgetTest, CheckParent) {
+  MemoryBudget parent{100};
+  MemoryBudget child1{80, &parent}, child2{0, &parent};
+
+  auto r1 = child1.Reserve(60);
+  EXPECT_TRUE(child1.Available());
+  EXPECT_TRUE(child2.Available());
+
+  auto r2 = child2.Reserve(60);
+  EXPECT_EQ(parent.current(), 120);
+  EXPECT_FALSE(child1.Available());
+  EXPECT_FALSE(child2.Available());
+
+  r2 = MemoryBudget::Reservation();
+  EXPECT_EQ(parent.current(), 60);
+  EXPECT_EQ(child2.current(), 0);
+  EXPECT_TRUE(child2.Available());
+}
+
+TEST(MemoryBudgetTest, CheckWait) {
+  MemoryBudget parent{100};
+  MemoryBudget child{50, &parent};
+
+  int called = 0;
+  child.Wait([&called]() { called++; });
+  EXPECT_EQ(called, 1);
+
+  auto r1 = parent.Reserve(100);
+  child.Wait([&called]() { called++; });
+  EXPECT_EQ(called, 1);
+
+  auto r2 = child.Reserve(50);
+  r1.Release();
+  EXPECT_EQ(called, 2);
+
+  child.Wait([&called]() { called++; });
+  EXPECT_EQ(called, 2);
+  child.set_limit(100);
+  EXPECT_EQ(called, 3);
+}
@@ -0,0 +1,121 @@
+// MIT License
+
+// Copyright (c) 2018 Zhuhao Wang
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <nekit/utils/runloop.h>
+#include <nekit/utils/timer.h>
+
+using namespace nekit::utils;
+
+namespace {
+// Run the runloop until there is nothing left to wait for.
+void RunAll(Runloop* runloop) {
+  runloop->BoostIoContext()->restart();
+  runloop->BoostIoContext()->run();
+}
+}  // namespace
+
+TEST(TimerWheelTest, FiresInOrder) {
+  Runloop runloop;
+  std::vector<int> fired;
+
+  WheelTimer t1{&runloop, [&fired]() { fired.push_back(1); }};
+  WheelTimer t2{&runloop, [&fired]() { fired.push_back(2); }};
+  WheelTimer t3{&runloop, [&fired]() { fired.push_back(3); }};
+  t1.Wait(60);
+  t2.Wait(20);
+  t3.Wait(40);
+  EXPECT_EQ(runloop.GetTimerWheel()->size(), 3);
+
+  RunAll(&runloop);
+  EXPECT_EQ(fired, (std::vector<int>{2, 3, 1}));
+  EXPECT_EQ(runloop.GetTimerWheel()->size(), 0);
+}
+
+TEST(TimerWheelTest, WaitAgainMovesDeadline) {
+  Runloop runloop;
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::duration elapsed;
+  int fired = 0;
+
+  WheelTimer timer{&runloop, [&]() {
+                     fired++;
+                     elapsed = std::chrono::steady_clock::now() - start;
+                   }};
+  timer.Wait(100);
+  timer.Wait(20);
+  timer.Wait(50);
+
+  RunAll(&runloop);
+  EXPECT_EQ(fired, 1);
+  EXPECT_GE(elapsed, std::chrono::milliseconds(50));
+  EXPECT_LT(elapsed, std::chrono::milliseconds(100));
+}
+
+TEST(TimerWheelTest, LongerThanOneRevolution) {
+  Runloop runloop;
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::duration elapsed;
+  uint32_t timeout = NEKIT_TIMER_WHEEL_TICK * NEKIT_TIMER_WHEEL_SLOT_COUNT / 8;
+
+  WheelTimer timer{&runloop, [&]() {
+                     elapsed = std::chrono::steady_clock::now() - start;
+                   }};
+  timer.Wait(timeout);
+  // Moving the deadline past one revolution from the same slot.
+  timer.Wait(timeout +
+             NEKIT_TIMER_WHEEL_TICK * NEKIT_TIMER_WHEEL_SLOT_COUNT / 8);
+
+  RunAll(&runloop);
+  EXPECT_GE(elapsed, std::chrono::milliseconds(timeout * 2));
+}
+
+TEST(TimerWheelTest, CancelAndRelease) {
+  Runloop runloop;
+  int fired = 0;
+
+  auto t1 = std::make_unique<WheelTimer>(&runloop, [&fired]() { fired++; });
+  auto t2 = std::make_unique<WheelTimer>(&runloop, [&fired]() { fired++; });
+  std::unique_ptr<WheelTimer> t3;
+  // Expiring one timer releases the others in the same slot.
+  t3 = std::make_unique<WheelTimer>(&runloop, [&]() {
+    fired++;
+    t1.reset();
+    t2.reset();
+  });
+  t3->Wait(10);
+  t1->Wait(10);
+  t2->Wait(10);
+
+  WheelTimer t4{&runloop, [&fired]() { fired++; }};
+  t4.Wait(10);
+  t4.Cancel();
+
+  RunAll(&runloop);
+  EXPECT_EQ(fired, 1);
+  EXPECT_EQ(runloop.GetTimerWheel()->size(), 0);
+}